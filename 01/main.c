@@ -1,13 +1,15 @@
-#include <sys/mman.h>
-#include <sys/stat.h>
-
 #include <assert.h>
 #include <ctype.h>
-#include <fcntl.h>
+#include <err.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+
+#include "cache.h"
+#include "solve.h"
+
+#define CACHE_DAY 1
 
 typedef struct {
 	void   *(*alloc)(size_t size);
@@ -20,23 +22,14 @@ static const Allocator default_allocator = {
 };
 
 typedef struct {
-	char     *content;
-	size_t    size;
-	char    **lines;
-	size_t    line_count;
-} Mapped_File;
+	const char   *content;
+	size_t        size;
+	const char  **lines;
+	size_t        line_count;
+} Lines;
 
 static int
-get_file_size(int fd, size_t *size)
-{
-	struct stat sb;
-	if (fstat(fd, &sb) == -1) return -1;
-	*size = sb.st_size;
-	return 0;
-}
-
-static int
-index_lines(Mapped_File *file, const Allocator *allocator)
+index_lines(Lines *file, const Allocator *allocator)
 {
 	assert(file != NULL);
 	assert(allocator != NULL);
@@ -62,79 +55,8 @@ index_lines(Mapped_File *file, const Allocator *allocator)
 	return 0;
 }
 
-Mapped_File *
-map_file(const char *filename, const Allocator *allocator)
-{
-	assert(filename != NULL);
-	assert(filename[0] != '\0');
-	assert(allocator != NULL);
-	assert(allocator->alloc != NULL);
-	assert(allocator->free != NULL);
-
-	int fd = open(filename, O_RDONLY);
-	if (fd == -1) return NULL;
-
-	Mapped_File *file = allocator->alloc(sizeof(Mapped_File));
-	if (!file) {
-		close(fd);
-		return NULL;
-	}
-
-	// Zero initialize the struct.
-	memset(file, 0, sizeof(*file));
-
-	if (get_file_size(fd, &file->size) == -1) {
-		close(fd);
-		allocator->free(file);
-		return NULL;
-	}
-
-	// Handle empty file.
-	if (file->size == 0) {
-		close(fd);
-		file->content = NULL;
-		file->lines = NULL;
-		return file;
-	}
-
-	// Map the file.
-	file->content = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
-	close(fd);
-
-	if (file->content == MAP_FAILED) {
-		allocator->free(file);
-		return NULL;
-	}
-
-	if (index_lines(file, allocator) == -1) {
-		munmap(file->content, file->size);
-		allocator->free(file->lines);
-		allocator->free(file);
-		return NULL;
-	}
-
-	return file;
-}
-
-void
-unmap_file(Mapped_File *file, const Allocator *allocator)
-{
-	if (!file) return;
-	assert(allocator != NULL);
-	assert(allocator->free != NULL);
-
-	if (file->content && file->size > 0) {
-		assert(file->content != MAP_FAILED);
-		munmap(file->content, file->size);
-	}
-	if (file->lines) {
-		allocator->free(file->lines);
-	}
-	allocator->free(file);
-}
-
-size_t
-get_line_length(const Mapped_File *file, size_t line_index)
+static size_t
+get_line_length(const Lines *file, size_t line_index)
 {
 	assert(file != NULL);
 	if (line_index >= file->line_count) return 0;
@@ -154,9 +76,9 @@ get_line_length(const Mapped_File *file, size_t line_index)
 	return len;
 }
 
-void
-parse_file(
-	const char *filename,
+static void
+parse_input(
+	const struct input *input,
 	int **left_col,
 	size_t *left_col_len,
 	int **right_col,
@@ -164,7 +86,7 @@ parse_file(
 	const Allocator *allocator
 )
 {
-	assert(filename != NULL);
+	assert(input != NULL);
 	assert(left_col != NULL);
 	assert(left_col_len != NULL);
 	assert(right_col != NULL);
@@ -178,22 +100,24 @@ parse_file(
 	*left_col_len = 0;
 	*right_col_len = 0;
 
-	Mapped_File *file = map_file(filename, allocator);
-	if (!file) return;
+	if (input->size == 0) return;
 
-	int *left = allocator->alloc(file->line_count * sizeof(int));
-	int *right = allocator->alloc(file->line_count * sizeof(int));
+	Lines lines = { .content = input->data, .size = input->size };
+	if (index_lines(&lines, allocator) == -1) return;
+
+	int *left = allocator->alloc(lines.line_count * sizeof(int));
+	int *right = allocator->alloc(lines.line_count * sizeof(int));
 
 	if (!left || !right) {
 		if (left) allocator->free(left);
 		if (right) allocator->free(right);
-		unmap_file(file, allocator);
+		allocator->free(lines.lines);
 		return;
 	}
 
-	for (size_t i = 0; i < file->line_count; ++i) {
-		const char *current_line = file->lines[i];
-		size_t line_len = get_line_length(file, i);
+	for (size_t i = 0; i < lines.line_count; ++i) {
+		const char *current_line = lines.lines[i];
+		size_t line_len = get_line_length(&lines, i);
 
 		if (line_len == 0) {
 			left[i] = right[i] = 0;
@@ -229,12 +153,54 @@ parse_file(
 
 	*left_col = left;
 	*right_col = right;
-	*left_col_len = *right_col_len = file->line_count;
+	*left_col_len = *right_col_len = lines.line_count;
+
+	allocator->free(lines.lines);
+}
+
+// The cache holds the two columns, as int arrays of the same length.
+static int
+load_cache(
+	const struct input *input,
+	struct cache *cache,
+	int **left_col,
+	int **right_col,
+	size_t *col_len
+)
+{
+	assert(input != NULL);
+	assert(cache != NULL);
+
+	if (cache_open(cache, input, CACHE_DAY) == -1) return -1;
+	if (cache->nsections != 2 || cache->size[0] != cache->size[1] ||
+		cache->size[0] % sizeof(int) != 0) {
+		cache_close(cache);
+		return -1;
+	}
+
+	*left_col = cache->section[0];
+	*right_col = cache->section[1];
+	*col_len = cache->size[0] / sizeof(int);
+	return 0;
+}
 
-	unmap_file(file, allocator);
+static void
+free_columns(
+	struct cache *cache,
+	int *left_col,
+	int *right_col,
+	const Allocator *allocator
+)
+{
+	if (cache->map) {
+		cache_close(cache);
+		return;
+	}
+	allocator->free(right_col);
+	allocator->free(left_col);
 }
 
-void
+static void
 insertion_sort(int *A, int len)
 {
 	assert(A != NULL);
@@ -253,7 +219,7 @@ insertion_sort(int *A, int len)
 	}
 }
 
-int *
+static int *
 filter_array(int *values, size_t len, const Allocator *allocator)
 {
 	assert(values != NULL);
@@ -274,23 +240,30 @@ filter_array(int *values, size_t len, const Allocator *allocator)
 }
 
 int
-main(void)
+solve_day01(const struct input *input, struct results *results)
 {
 	const Allocator *allocator = &default_allocator;
 	int *left_col = NULL, *right_col = NULL;
 	size_t col_len = 0;
-
-	parse_file("input.txt", &left_col, &col_len, &right_col, &col_len, allocator);
-	if (!left_col || !right_col) {
-		fprintf(stderr, "failed to parse file\n");
-		return 1;
+	struct cache cache = {0};
+	struct phase *phase;
+
+	// A fresh cache stands in for the text, columns and all.
+	phase = results_phase(results, "parse");
+	if (load_cache(input, &cache, &left_col, &right_col, &col_len) == -1) {
+		parse_input(input, &left_col, &col_len, &right_col, &col_len, allocator);
+		if (!left_col || !right_col) {
+			return -1;
+		}
 	}
+	phase_end(phase);
 
 	// Part 2 is first because part 1 requires sorting the arrays.
+	phase = results_phase(results, "part2");
 	int *filtered = filter_array(left_col, col_len, allocator);
 	if (!filtered) {
-		fprintf(stderr, "failed to allocate filtered array\n");
-		goto cleanup;
+		free_columns(&cache, left_col, right_col, allocator);
+		return -1;
 	}
 
 	int similarities_sum = 0;
@@ -307,10 +280,12 @@ main(void)
 		similarities_sum += current * duplicates;
 	}
 	allocator->free(filtered);
+	phase_end(phase);
 
-	printf("Similarities sum =\n\t%d\n", similarities_sum);
+	sprintf(results->part2, "%d", similarities_sum);
 
 	// Part 1.
+	phase = results_phase(results, "part1");
 	insertion_sort(left_col, col_len);
 	insertion_sort(right_col, col_len);
 
@@ -318,11 +293,73 @@ main(void)
 	for (size_t i = 0; i < col_len; ++i) {
 		distances_sum += abs(left_col[i] - right_col[i]);
 	}
+	phase_end(phase);
 
-	printf("Distances sum =\n\t%d\n", distances_sum);
+	sprintf(results->part1, "%d", distances_sum);
+
+	free_columns(&cache, left_col, right_col, allocator);
+	return 0;
+}
+
+#ifndef AOC_RUNNER
+static int
+write_cache(const struct input *input)
+{
+	const Allocator *allocator = &default_allocator;
+	int *left_col = NULL, *right_col = NULL;
+	size_t col_len = 0;
+
+	parse_input(input, &left_col, &col_len, &right_col, &col_len, allocator);
+	if (!left_col || !right_col) return -1;
+
+	struct cache cache = {
+		.section   = { left_col, right_col },
+		.size      = { col_len * sizeof(int), col_len * sizeof(int) },
+		.nsections = 2,
+	};
+	int rc = cache_write(&cache, input, CACHE_DAY);
 
-cleanup:
 	allocator->free(right_col);
 	allocator->free(left_col);
+	return rc;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct input input;
+	struct results results;
+
+	// With -c, write the cache of the input instead of solving it.
+	bool convert = argc > 1 && strcmp(argv[1], "-c") == 0;
+	if (argc - convert > 2) {
+		fprintf(stderr, "usage: main.exe [-c] [input.txt | -]\n");
+		return 1;
+	}
+	const char *path = argc - convert == 2 ? argv[1 + convert] : "input.txt";
+	if (input_load(&input, path) == -1) {
+		err(1, "%s", path);
+	}
+	if (convert) {
+		if (write_cache(&input) == -1) {
+			warn("%s.bin", path);
+			input_close(&input);
+			return 1;
+		}
+		input_close(&input);
+		return 0;
+	}
+
+	results_init(&results);
+	if (solve_day01(&input, &results) == -1) {
+		fprintf(stderr, "failed to parse file\n");
+		input_close(&input);
+		return 1;
+	}
+	input_close(&input);
+
+	printf("Similarities sum =\n\t%s\n", results.part2);
+	printf("Distances sum =\n\t%s\n", results.part1);
 	return 0;
 }
+#endif
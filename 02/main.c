@@ -1,14 +1,15 @@
-#include <sys/mman.h>
-#include <sys/stat.h>
-
 #include <assert.h>
 #include <ctype.h>
-#include <fcntl.h>
+#include <err.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+
+#include "cache.h"
+#include "solve.h"
+
+#define CACHE_DAY 2
 
 typedef struct {
 	void   *(*alloc)(size_t size);
@@ -26,12 +27,13 @@ typedef struct {
 	size_t cap;
 } Dynamic_Array;
 
-void
+static int
 da_append(Dynamic_Array *da, int value, const Allocator *allocator)
 {
 	if (da->len >= da->cap) {
 		size_t new_cap = da->cap * 2;
 		int *new_array = allocator->alloc(new_cap * sizeof(int));
+		if (!new_array) return -1;
 		memcpy(new_array, da->array, da->len * sizeof(int));
 
 		allocator->free(da->array);
@@ -41,26 +43,18 @@ da_append(Dynamic_Array *da, int value, const Allocator *allocator)
 
 	da->array[da->len] = value;
 	++da->len;
+	return 0;
 }
 
 typedef struct {
-	char     *content;
-	size_t    size;
-	char    **lines;
-	size_t    line_count;
-} Mapped_File;
-
-static int
-get_file_size(int fd, size_t *size)
-{
-	struct stat sb;
-	if (fstat(fd, &sb) == -1) return -1;
-	*size = sb.st_size;
-	return 0;
-}
+	const char   *content;
+	size_t        size;
+	const char  **lines;
+	size_t        line_count;
+} Lines;
 
 static int
-index_lines(Mapped_File *file, const Allocator *allocator)
+index_lines(Lines *file, const Allocator *allocator)
 {
 	assert(file != NULL);
 	assert(allocator != NULL);
@@ -86,79 +80,8 @@ index_lines(Mapped_File *file, const Allocator *allocator)
 	return 0;
 }
 
-Mapped_File *
-map_file(const char *filename, const Allocator *allocator)
-{
-	assert(filename != NULL);
-	assert(filename[0] != '\0');
-	assert(allocator != NULL);
-	assert(allocator->alloc != NULL);
-	assert(allocator->free != NULL);
-
-	int fd = open(filename, O_RDONLY);
-	if (fd == -1) return NULL;
-
-	Mapped_File *file = allocator->alloc(sizeof(Mapped_File));
-	if (!file) {
-		close(fd);
-		return NULL;
-	}
-
-	// Zero initialize the struct.
-	memset(file, 0, sizeof(*file));
-
-	if (get_file_size(fd, &file->size) == -1) {
-		close(fd);
-		allocator->free(file);
-		return NULL;
-	}
-
-	// Handle empty file.
-	if (file->size == 0) {
-		close(fd);
-		file->content = NULL;
-		file->lines = NULL;
-		return file;
-	}
-
-	// Map the file.
-	file->content = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
-	close(fd);
-
-	if (file->content == MAP_FAILED) {
-		allocator->free(file);
-		return NULL;
-	}
-
-	if (index_lines(file, allocator) == -1) {
-		munmap(file->content, file->size);
-		allocator->free(file->lines);
-		allocator->free(file);
-		return NULL;
-	}
-
-	return file;
-}
-
-void
-unmap_file(Mapped_File *file, const Allocator *allocator)
-{
-	if (!file) return;
-	assert(allocator != NULL);
-	assert(allocator->free != NULL);
-
-	if (file->content && file->size > 0) {
-		assert(file->content != MAP_FAILED);
-		munmap(file->content, file->size);
-	}
-	if (file->lines) {
-		allocator->free(file->lines);
-	}
-	allocator->free(file);
-}
-
-size_t
-get_line_length(const Mapped_File *file, size_t line_index)
+static size_t
+get_line_length(const Lines *file, size_t line_index)
 {
 	assert(file != NULL);
 	if (line_index >= file->line_count) return 0;
@@ -178,40 +101,62 @@ get_line_length(const Mapped_File *file, size_t line_index)
 	return len;
 }
 
-void
-parse_file(
-	const char *filename,
-	int *safe_reports,
+// Every report's levels, back to back: report i is
+// levels.array[offsets[i]..offsets[i + 1]).  Loaded from a cache, both
+// arrays point into its mapping.
+typedef struct {
+	Dynamic_Array levels;
+	size_t       *offsets;
+	size_t        count;
+	struct cache  cache;
+} Reports;
+
+static void
+free_reports(Reports *reports, const Allocator *allocator)
+{
+	if (reports->cache.map) {
+		cache_close(&reports->cache);
+		return;
+	}
+	allocator->free(reports->levels.array);
+	allocator->free(reports->offsets);
+}
+
+static int
+parse_input(
+	const struct input *input,
+	Reports *reports,
 	const Allocator *allocator
 )
 {
-	assert(filename != NULL);
-	assert(safe_reports != NULL);
+	assert(input != NULL);
+	assert(reports != NULL);
 	assert(allocator != NULL);
 	assert(allocator->alloc != NULL);
 	assert(allocator->free != NULL);
 
-	Mapped_File *file = map_file(filename, allocator);
-	if (!file) {
-		fprintf(stderr, "failed to map file\n");
-		return;
+	if (input->size == 0) return -1;
+
+	Lines lines = { .content = input->data, .size = input->size };
+	if (index_lines(&lines, allocator) == -1) return -1;
+
+	reports->cache = (struct cache){0};
+	reports->count = 0;
+	reports->levels.len = 0;
+	reports->levels.cap = 32;
+	reports->levels.array = allocator->alloc(32 * sizeof(int));
+	reports->offsets = allocator->alloc((lines.line_count + 1) * sizeof(size_t));
+	if (!reports->levels.array || !reports->offsets) {
+		free_reports(reports, allocator);
+		allocator->free(lines.lines);
+		return -1;
 	}
 
-	*safe_reports = 0;
+	for (size_t i = 0; i < lines.line_count; ++i) {
+		const char *current_line = lines.lines[i];
+		size_t line_len = get_line_length(&lines, i);
 
-	for (size_t i = 0; i < file->line_count; ++i) {
-		const char *current_line = file->lines[i];
-		size_t line_len = get_line_length(file, i);
-
-		Dynamic_Array da;
-		da.array = allocator->alloc(32 * sizeof(int));
-		if (!da.array) {
-			fprintf(stderr, "failed to allocate array\n");
-			unmap_file(file, allocator);
-			return;
-		}
-		da.len = 0;
-		da.cap = 32;
+		reports->offsets[reports->count++] = reports->levels.len;
 
 		char strn[16] = {0};
 		size_t j = 0;
@@ -226,20 +171,67 @@ parse_file(
 
 			if ((!isdigit(current_line[pos]) || pos == line_len - 1) && j > 0) {
 				strn[j] = '\0';
-				da_append(&da, atoi(strn), allocator);
+				if (da_append(&reports->levels, atoi(strn), allocator) == -1) {
+					free_reports(reports, allocator);
+					allocator->free(lines.lines);
+					return -1;
+				}
 				j = 0;
 				memset(strn, 0, sizeof(strn));
 			}
 			++pos;
 		}
+	}
+	reports->offsets[reports->count] = reports->levels.len;
+
+	allocator->free(lines.lines);
+	return 0;
+}
+
+// The cache holds the levels as ints and the count + 1 offsets as size_t.
+static int
+load_cache(const struct input *input, Reports *reports)
+{
+	assert(input != NULL);
+	assert(reports != NULL);
+
+	struct cache *cache = &reports->cache;
+	if (cache_open(cache, input, CACHE_DAY) == -1) return -1;
+
+	size_t nlevels = cache->size[0] / sizeof(int);
+	size_t noffsets = cache->size[1] / sizeof(size_t);
+	if (cache->nsections != 2 || cache->size[0] % sizeof(int) != 0 ||
+		cache->size[1] % sizeof(size_t) != 0 || noffsets == 0 ||
+		((size_t *)cache->section[1])[noffsets - 1] != nlevels) {
+		cache_close(cache);
+		return -1;
+	}
+
+	reports->levels.array = cache->section[0];
+	reports->levels.len = reports->levels.cap = nlevels;
+	reports->offsets = cache->section[1];
+	reports->count = noffsets - 1;
+	return 0;
+}
+
+static int
+count_safe_reports(const Reports *reports)
+{
+	assert(reports != NULL);
+
+	int safe_reports = 0;
+
+	for (size_t i = 0; i < reports->count; ++i) {
+		const int *levels = &reports->levels.array[reports->offsets[i]];
+		size_t len = reports->offsets[i + 1] - reports->offsets[i];
 
 		bool is_valid = true;
-		if (da.len >= 2) {
-			int direction = da.array[1] - da.array[0];
+		if (len >= 2) {
+			int direction = levels[1] - levels[0];
 			bool inc = direction > 0;
 
-			for (size_t k = 1; k < da.len; ++k) {
-				int diff = da.array[k] - da.array[k-1];
+			for (size_t k = 1; k < len; ++k) {
+				int diff = levels[k] - levels[k-1];
 				int abs_diff = abs(diff);
 
 				if (abs_diff < 1 || abs_diff > 3 || (inc && diff <= 0) || (!inc && diff >= 0)) {
@@ -249,77 +241,31 @@ parse_file(
 			}
 
 			if (is_valid) {
-				++(*safe_reports);
+				++safe_reports;
 			}
 		}
-
-		allocator->free(da.array);
 	}
 
-	unmap_file(file, allocator);
+	return safe_reports;
 }
 
-void
-parse_file2(
-	const char *filename,
-	int *safe_reports,
-	const Allocator *allocator
-)
+static int
+count_safe_reports_dampened(const Reports *reports)
 {
-	assert(filename != NULL);
-	assert(safe_reports != NULL);
-	assert(allocator != NULL);
-	assert(allocator->alloc != NULL);
-	assert(allocator->free != NULL);
-
-	Mapped_File *file = map_file(filename, allocator);
-	if (!file) {
-		fprintf(stderr, "failed to map file\n");
-		return;
-	}
-
-	*safe_reports = 0;
-
-	for (size_t i = 0; i < file->line_count; ++i) {
-		const char *current_line = file->lines[i];
-		size_t line_len = get_line_length(file, i);
+	assert(reports != NULL);
 
-		Dynamic_Array da;
-		da.array = allocator->alloc(32 * sizeof(int));
-		if (!da.array) {
-			fprintf(stderr, "failed to allocate array\n");
-			unmap_file(file, allocator);
-			return;
-		}
-		da.len = 0;
-		da.cap = 32;
-
-		char strn[16] = {0};
-		size_t j = 0;
-		size_t pos = 0;
-
-		while (pos < line_len) {
-			if (isdigit(current_line[pos])) {
-				if (j < sizeof(strn) - 1) {
-					strn[j++] = current_line[pos];
-				}
-			}
+	int safe_reports = 0;
 
-			if ((!isdigit(current_line[pos]) || pos == line_len - 1) && j > 0) {
-				strn[j] = '\0';
-				da_append(&da, atoi(strn), allocator);
-				j = 0;
-				memset(strn, 0, sizeof(strn));
-			}
-			++pos;
-		}
+	for (size_t i = 0; i < reports->count; ++i) {
+		const int *levels = &reports->levels.array[reports->offsets[i]];
+		size_t len = reports->offsets[i + 1] - reports->offsets[i];
 
 		bool is_valid = false;
-		if (da.len >= 2) {
+		if (len >= 2) {
 			for (int inc = 0; inc <= 1 && !is_valid; ++inc) {
 				bool valid_sequence = true;
-				for (size_t k = 1; k < da.len && valid_sequence; ++k) {
-					int diff = da.array[k] - da.array[k-1];
+				for (size_t k = 1; k < len && valid_sequence; ++k) {
+					int diff = levels[k] - levels[k-1];
 					int abs_diff = abs(diff);
 					if (abs_diff < 1 || abs_diff > 3 || (inc && diff <= 0) || (!inc && diff >= 0)) {
 						valid_sequence = false;
@@ -331,23 +277,23 @@ parse_file2(
 			}
 		}
 
-		if (!is_valid && da.len >= 3) {
-			for (size_t skip = 0; skip < da.len && !is_valid; ++skip) {
+		if (!is_valid && len >= 3) {
+			for (size_t skip = 0; skip < len && !is_valid; ++skip) {
 				for (int inc = 0; inc <= 1 && !is_valid; ++inc) {
 					bool valid_sequence = true;
 					int prev = -1;
 
-					for (size_t k = 0; k < da.len && valid_sequence; ++k) {
+					for (size_t k = 0; k < len && valid_sequence; ++k) {
 						if (k == skip) continue;
 
 						if (prev != -1) {
-							int diff = da.array[k] - prev;
+							int diff = levels[k] - prev;
 							int abs_diff = abs(diff);
 							if (abs_diff < 1 || abs_diff > 3 || (inc && diff <= 0) || (!inc && diff >= 0)) {
 								valid_sequence = false;
 							}
 						}
-						prev = da.array[k];
+						prev = levels[k];
 					}
 
 					if (valid_sequence) {
@@ -358,38 +304,105 @@ parse_file2(
 		}
 
 		if (is_valid) {
-			++(*safe_reports);
+			++safe_reports;
 		}
-
-		allocator->free(da.array);
 	}
 
-	unmap_file(file, allocator);
+	return safe_reports;
 }
 
 int
-main(void)
+solve_day02(const struct input *input, struct results *results)
 {
 	const Allocator *allocator = &default_allocator;
-	int safe_reports = 0;
+	Reports reports;
+	struct phase *phase;
+
+	// A fresh cache stands in for the text.
+	phase = results_phase(results, "parse");
+	if (load_cache(input, &reports) == -1 &&
+		parse_input(input, &reports, allocator) == -1) {
+		return -1;
+	}
+	phase_end(phase);
 
 	// Part 1.
-	parse_file("input.txt", &safe_reports, allocator);
-	if (!safe_reports) {
-		fprintf(stderr, "failed to parse file\n");
-		return 1;
-	}
+	phase = results_phase(results, "part1");
+	int safe_reports = count_safe_reports(&reports);
+	phase_end(phase);
 
-	printf("Number of safe reports =\n\t%d\n", safe_reports);
+	sprintf(results->part1, "%d", safe_reports);
 
 	// Part 2.
-	parse_file2("input.txt", &safe_reports, allocator);
-	if (!safe_reports) {
-		fprintf(stderr, "failed to parse file\n");
+	phase = results_phase(results, "part2");
+	safe_reports = count_safe_reports_dampened(&reports);
+	phase_end(phase);
+
+	sprintf(results->part2, "%d", safe_reports);
+
+	free_reports(&reports, allocator);
+	return 0;
+}
+
+#ifndef AOC_RUNNER
+static int
+write_cache(const struct input *input)
+{
+	const Allocator *allocator = &default_allocator;
+	Reports reports;
+
+	if (parse_input(input, &reports, allocator) == -1) return -1;
+
+	struct cache cache = {
+		.section   = { reports.levels.array, reports.offsets },
+		.size      = {
+			reports.levels.len * sizeof(int),
+			(reports.count + 1) * sizeof(size_t),
+		},
+		.nsections = 2,
+	};
+	int rc = cache_write(&cache, input, CACHE_DAY);
+
+	free_reports(&reports, allocator);
+	return rc;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct input input;
+	struct results results;
+
+	// With -c, write the cache of the input instead of solving it.
+	bool convert = argc > 1 && strcmp(argv[1], "-c") == 0;
+	if (argc - convert > 2) {
+		fprintf(stderr, "usage: main.exe [-c] [input.txt | -]\n");
 		return 1;
 	}
+	const char *path = argc - convert == 2 ? argv[1 + convert] : "input.txt";
+	if (input_load(&input, path) == -1) {
+		err(1, "%s", path);
+	}
+	if (convert) {
+		if (write_cache(&input) == -1) {
+			warn("%s.bin", path);
+			input_close(&input);
+			return 1;
+		}
+		input_close(&input);
+		return 0;
+	}
 
-	printf("Number of safe reports (with a single bad jump) =\n\t%d\n", safe_reports);
+	results_init(&results);
+	if (solve_day02(&input, &results) == -1) {
+		fprintf(stderr, "failed to parse file\n");
+		input_close(&input);
+		return 1;
+	}
+	input_close(&input);
 
+	printf("Number of safe reports =\n\t%s\n", results.part1);
+	printf("Number of safe reports (with a single bad jump) =\n\t%s\n", results.part2);
 	return 0;
 }
+#endif
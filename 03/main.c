@@ -4,44 +4,24 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define MAX_LENGTH 32768
-
-char *
-read_expression_from_file(const char* filename)
-{
-	FILE* file = fopen(filename, "r");
-	if (!file) {
-		perror("Error opening file");
-		return NULL;
-	}
-
-	char* expression = malloc(MAX_LENGTH);
-	if (!expression) {
-		fclose(file);
-		return NULL;
-	}
-
-	size_t bytes_read = fread(expression, 1, MAX_LENGTH - 1, file);
-	expression[bytes_read] = '\0';
-
-	fclose(file);
-	return expression;
-}
+#include "solve.h"
 
 int
-main(void)
+solve_day03(const struct input *input, struct results *results)
 {
-	char *expression = read_expression_from_file("input.txt");
+	struct phase *phase;
+
+	// The input ends in a NUL byte, so looking ahead never runs off it.
+	const char *expression = input->data;
+	size_t len = input->size;
 
 	// advance til mul(
 	// advance til , if digits
 	// advance til ) if digits
 
-	size_t len = strlen(expression);
-
 	// Part 1.
-	int nums[1024] = {0};
-	size_t nums_start = 0;
+	phase = results_phase(results, "part1");
+	long sum = 0;
 	for (size_t i = 0; i < len; ++i) {
 		// found mul(
 		if ((i < len && i + 1 < len && i + 2 < len && i + 3 < len) &&
@@ -74,21 +54,17 @@ main(void)
 			digit_str[digit_start] = '\0';
 			second_digit = atoi(digit_str);
 
-			nums[nums_start] = first_digit * second_digit;
-
-			++nums_start;
+			sum += (long)first_digit * second_digit;
 		}
 	}
 
-	int sum = 0;
-	for (size_t i = 0; i < nums_start; ++i) {
-		sum += nums[i];
-	}
+	phase_end(phase);
 
-	printf("sum 1 =\n\t%d\n", sum);
+	sprintf(results->part1, "%ld", sum);
 
 	// Part 2.
-	nums_start = 0;
+	phase = results_phase(results, "part2");
+	sum = 0;
 	bool cancel = false;
 	bool consecutive_cancel = false;
 	for (size_t i = 0; i < len; ++i) {
@@ -143,18 +119,40 @@ main(void)
 			digit_str[digit_start] = '\0';
 			second_digit = atoi(digit_str);
 
-			nums[nums_start] = first_digit * second_digit;
-
-			++nums_start;
+			sum += (long)first_digit * second_digit;
 		}
 	}
 
-	sum = 0;
-	for (size_t i = 0; i < nums_start; ++i) {
-		sum += nums[i];
+	phase_end(phase);
+
+	sprintf(results->part2, "%ld", sum);
+
+	return 0;
+}
+
+#ifndef AOC_RUNNER
+int
+main(int argc, char *argv[])
+{
+	struct input input;
+	struct results results;
+
+	if (argc > 2) {
+		fprintf(stderr, "usage: main.exe [input.txt | -]\n");
+		return 1;
+	}
+	const char *path = argc == 2 ? argv[1] : "input.txt";
+	if (input_load(&input, path) == -1) {
+		perror("Error opening file");
+		return 1;
 	}
 
-	printf("sum 2 =\n\t%d\n", sum);
+	results_init(&results);
+	solve_day03(&input, &results);
+	input_close(&input);
 
+	printf("sum 1 =\n\t%s\n", results.part1);
+	printf("sum 2 =\n\t%s\n", results.part2);
 	return 0;
 }
+#endif
@@ -2,20 +2,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "solve.h"
+
+#define MAX_WIDTH	8192
+
 int
-main(void)
+solve_day04(const struct input *input, struct results *results)
 {
 	FILE *fp;
-	char line[1024];
+	char line[MAX_WIDTH + 2];
 	char **grid;
 	int rows, cols, i, j, dx, dy;
 	int xmas, mas, diag1, diag2;
+	struct phase *phase;
 
-	fp = fopen("input.txt", "r");
-	if (fp == NULL) {
-		printf("cannot open file\n");
-		return 1;
-	}
+	phase = results_phase(results, "parse");
+	fp = input_stream(input);
+	if (fp == NULL)
+		return -1;
 
 	/* count dimensions */
 	rows = cols = 0;
@@ -37,7 +41,10 @@ main(void)
 		}
 	}
 
+	phase_end(phase);
+
 	/* part 1 -- find XMAS */
+	phase = results_phase(results, "part1");
 	xmas = 0;
 	for (i = 0; i < rows; ++i) {
 		for (j = 0; j < cols; ++j) {
@@ -58,9 +65,11 @@ main(void)
 			}
 		}
 	}
-	printf("XMAS found =\n\t%d\n", xmas);
+	phase_end(phase);
+	sprintf(results->part1, "%d", xmas);
 
 	/* part 2 -- find X pattern of MAS */
+	phase = results_phase(results, "part2");
 	mas = 0;
 	for (i = 1; i < rows-1; ++i) {
 		for (j = 1; j < cols-1; ++j) {
@@ -78,7 +87,8 @@ main(void)
 				++mas;
 		}
 	}
-	printf("MAS found =\n\t%d\n", mas);
+	phase_end(phase);
+	sprintf(results->part2, "%d", mas);
 
 	/* cleanup */
 	for (i = 0; i < rows; ++i)
@@ -87,3 +97,33 @@ main(void)
 	fclose(fp);
 	return 0;
 }
+
+#ifndef AOC_RUNNER
+int
+main(int argc, char *argv[])
+{
+	struct input input;
+	struct results results;
+
+	if (argc > 2) {
+		printf("usage: main.exe [input.txt | -]\n");
+		return 1;
+	}
+	if (input_load(&input, argc == 2 ? argv[1] : "input.txt") == -1) {
+		printf("cannot open file\n");
+		return 1;
+	}
+
+	results_init(&results);
+	if (solve_day04(&input, &results) == -1) {
+		printf("cannot open file\n");
+		input_close(&input);
+		return 1;
+	}
+	input_close(&input);
+
+	printf("XMAS found =\n\t%s\n", results.part1);
+	printf("MAS found =\n\t%s\n", results.part2);
+	return 0;
+}
+#endif
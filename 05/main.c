@@ -5,9 +5,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cache.h"
+#include "solve.h"
+
+#define CACHE_DAY	5
 #define MAX_LINE	4096
-#define MAX_RULES	4096
-#define MAX_UPDATES	4096
+#define INITIAL_RULES	4096
+#define INITIAL_UPDATES	4096
 #define MAX_PAGES	256
 
 struct rule {
@@ -231,23 +235,38 @@ parse_update(char *line, struct update *update)
 	return 0;
 }
 
+/* Double the room in array, which holds *cap elements of the given size. */
+static void *
+grow_array(void *array, size_t *cap, size_t size)
+{
+	void *grown;
+
+	grown = realloc(array, *cap * 2 * size);
+	if (grown != NULL)
+		*cap *= 2;
+	return grown;
+}
+
 static int
-read_input(const char *filename, struct rule **rules, size_t *nrules,
+read_input(const struct input *input, struct rule **rules, size_t *nrules,
 	struct update **updates, size_t *nupdates)
 {
 	FILE *fp;
 	char line[MAX_LINE];
 	struct rule *r;
 	struct update *u;
-	size_t nr, nu;
+	size_t nr, nu, rcap, ucap;
+	void *grown;
 	int in_updates;
 
-	fp = fopen(filename, "r");
+	fp = input_stream(input);
 	if (fp == NULL)
-		err(1, "fopen");
+		return -1;
 
-	r = malloc(MAX_RULES * sizeof(*r));
-	u = malloc(MAX_UPDATES * sizeof(*u));
+	rcap = INITIAL_RULES;
+	ucap = INITIAL_UPDATES;
+	r = malloc(rcap * sizeof(*r));
+	u = malloc(ucap * sizeof(*u));
 	if (r == NULL || u == NULL) {
 		free(r);
 		free(u);
@@ -267,11 +286,14 @@ read_input(const char *filename, struct rule **rules, size_t *nrules,
 		}
 
 		if (!in_updates) {
-			if (nr >= MAX_RULES) {
-				free(r);
-				free(u);
-				fclose(fp);
-				return -1;
+			if (nr == rcap) {
+				if ((grown = grow_array(r, &rcap, sizeof(*r))) == NULL) {
+					free(r);
+					free(u);
+					fclose(fp);
+					return -1;
+				}
+				r = grown;
 			}
 			if (parse_rule(line, &r[nr]) == -1) {
 				free(r);
@@ -281,11 +303,14 @@ read_input(const char *filename, struct rule **rules, size_t *nrules,
 			}
 			++nr;
 		} else {
-			if (nu >= MAX_UPDATES) {
-				free(r);
-				free_updates(u, nu);
-				fclose(fp);
-				return -1;
+			if (nu == ucap) {
+				if ((grown = grow_array(u, &ucap, sizeof(*u))) == NULL) {
+					free(r);
+					free_updates(u, nu);
+					fclose(fp);
+					return -1;
+				}
+				u = grown;
 			}
 			if (parse_update(line, &u[nu]) == -1) {
 				free(r);
@@ -313,8 +338,59 @@ read_input(const char *filename, struct rule **rules, size_t *nrules,
 	return 0;
 }
 
+/*
+ * The cache holds the rules as they are, the pages of every update back to
+ * back, and the nupdates + 1 offsets of each update's pages among them.
+ * Only the update headers are built on load; their pages stay in the
+ * mapping.
+ */
+static int
+load_cache(const struct input *input, struct cache *cache,
+	struct rule **rules, size_t *nrules,
+	struct update **updates, size_t *nupdates)
+{
+	const size_t *offsets;
+	struct update *u;
+	size_t npages, noffsets, i;
+
+	if (cache_open(cache, input, CACHE_DAY) == -1)
+		return -1;
+
+	npages = cache->size[1] / sizeof(int);
+	noffsets = cache->size[2] / sizeof(size_t);
+	offsets = cache->section[2];
+	if (cache->nsections != 3 ||
+	    cache->size[0] % sizeof(struct rule) != 0 ||
+	    cache->size[1] % sizeof(int) != 0 ||
+	    cache->size[2] % sizeof(size_t) != 0 || noffsets == 0 ||
+	    offsets[noffsets - 1] != npages)
+		goto bad;
+
+	if ((u = malloc(noffsets * sizeof(*u))) == NULL)
+		goto bad;
+	for (i = 0; i + 1 < noffsets; ++i) {
+		if (offsets[i] > offsets[i + 1] ||
+		    offsets[i + 1] - offsets[i] > MAX_PAGES) {
+			free(u);
+			goto bad;
+		}
+		u[i].pages = (int *)cache->section[1] + offsets[i];
+		u[i].npages = offsets[i + 1] - offsets[i];
+	}
+
+	*rules = cache->section[0];
+	*nrules = cache->size[0] / sizeof(struct rule);
+	*updates = u;
+	*nupdates = noffsets - 1;
+	return 0;
+
+bad:
+	cache_close(cache);
+	return -1;
+}
+
 int
-main(void)
+solve_day05(const struct input *input, struct results *results)
 {
 	struct rule *rules;
 	struct update *updates;
@@ -327,12 +403,21 @@ main(void)
 	int valid;
 	int before_pos, after_pos;
 	int *sorted_pages;
-
-	if (read_input("input.txt", &rules, &nrules, &updates, &nupdates) == -1)
-		errx(1, "failed to parse input");
+	int rc = -1;
+	struct cache cache;
+	struct phase *phase;
+
+	/* a fresh cache stands in for the text */
+	phase = results_phase(results, "parse");
+	if (load_cache(input, &cache, &rules, &nrules, &updates,
+	    &nupdates) == -1 &&
+	    read_input(input, &rules, &nrules, &updates, &nupdates) == -1)
+		return -1;
+	phase_end(phase);
 
 
 	/* part 1 */
+	phase = results_phase(results, "part1");
 
 	/* process each update */
 	sum_middle_elements_part_1 = 0;
@@ -368,15 +453,17 @@ main(void)
 		}
 	}
 
-	printf("sum of middle elements from valid updates =\n\t%d\n", sum_middle_elements_part_1);
+	phase_end(phase);
+	sprintf(results->part1, "%d", sum_middle_elements_part_1);
 
 
 	/* part 2 */
+	phase = results_phase(results, "part2");
 	sum_middle_elements_part_2 = 0;
 
 	sorted_pages = malloc(MAX_PAGES * sizeof(*sorted_pages));
 	if (sorted_pages == NULL)
-		err(1, "malloc");
+		goto done;
 
 	for (i = 0; i < nupdates; ++i) {
 		valid = 1;
@@ -405,7 +492,7 @@ main(void)
 			/* create graph for this invalid update */
 			g = create_graph(rules, nrules, &updates[i]);
 			if (g == NULL)
-				err(1, "create_graph");
+				goto done;
 
 			/* sort it */
 			if (topological_sort(g, sorted_pages, updates[i].npages) == 0) {
@@ -417,13 +504,113 @@ main(void)
 		}
 	}
 
-	printf("sum of middle elements from corrected invalid updates =\n\t%d\n", sum_middle_elements_part_2);
+	phase_end(phase);
+	sprintf(results->part2, "%d", sum_middle_elements_part_2);
+	rc = 0;
 
 
-	/* cleanup */
+	/* cleanup, also after running out of memory */
+done:
 	free(sorted_pages);
+	if (cache.map != NULL) {
+		free(updates);
+		cache_close(&cache);
+	} else {
+		free(rules);
+		free_updates(updates, nupdates);
+	}
+
+	return rc;
+}
+
+#ifndef AOC_RUNNER
+static int
+write_cache(const struct input *input)
+{
+	struct cache cache;
+	struct rule *rules;
+	struct update *updates;
+	size_t nrules, nupdates, npages, *offsets, i;
+	int *pages, rc;
+
+	if (read_input(input, &rules, &nrules, &updates, &nupdates) == -1)
+		return -1;
+
+	npages = 0;
+	for (i = 0; i < nupdates; ++i)
+		npages += updates[i].npages;
+	pages = malloc((npages + 1) * sizeof(*pages));
+	offsets = malloc((nupdates + 1) * sizeof(*offsets));
+	if (pages == NULL || offsets == NULL) {
+		free(pages);
+		free(offsets);
+		free(rules);
+		free_updates(updates, nupdates);
+		return -1;
+	}
+
+	offsets[0] = 0;
+	for (i = 0; i < nupdates; ++i) {
+		memcpy(pages + offsets[i], updates[i].pages,
+		    updates[i].npages * sizeof(*pages));
+		offsets[i + 1] = offsets[i] + updates[i].npages;
+	}
+
+	memset(&cache, 0, sizeof(cache));
+	cache.section[0] = rules;
+	cache.size[0] = nrules * sizeof(*rules);
+	cache.section[1] = pages;
+	cache.size[1] = npages * sizeof(*pages);
+	cache.section[2] = offsets;
+	cache.size[2] = (nupdates + 1) * sizeof(*offsets);
+	cache.nsections = 3;
+	rc = cache_write(&cache, input, CACHE_DAY);
+
+	free(offsets);
+	free(pages);
 	free(rules);
 	free_updates(updates, nupdates);
+	return rc;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct input input;
+	struct results results;
+	const char *path;
+	int convert;
+
+	/* with -c, write the cache of the input instead of solving it */
+	convert = argc > 1 && strcmp(argv[1], "-c") == 0;
+	if (argc - convert > 2) {
+		fprintf(stderr, "usage: main.exe [-c] [input.txt | -]\n");
+		return 1;
+	}
+	path = argc - convert == 2 ? argv[1 + convert] : "input.txt";
+	if (input_load(&input, path) == -1)
+		err(1, "%s", path);
+	if (convert) {
+		if (write_cache(&input) == -1) {
+			warn("%s.bin", path);
+			input_close(&input);
+			return 1;
+		}
+		input_close(&input);
+		return 0;
+	}
+
+	results_init(&results);
+	if (solve_day05(&input, &results) == -1) {
+		input_close(&input);
+		errx(1, "failed to parse input");
+	}
+	input_close(&input);
 
+	printf("sum of middle elements from valid updates =\n\t%s\n",
+	    results.part1);
+	printf("sum of middle elements from corrected invalid updates =\n\t%s\n",
+	    results.part2);
 	return 0;
 }
+#endif
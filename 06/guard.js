@@ -0,0 +1,250 @@
+/* Guard patrol model shared by main.js and the loop search workers. */
+
+/** @typedef {0 | 1 | 2 | 3} Direction */
+export const /** @type {Direction} */ NORTH = 0;
+export const /** @type {Direction} */ EAST = 1;
+export const /** @type {Direction} */ SOUTH = 2;
+export const /** @type {Direction} */ WEST = 3;
+
+/** @typedef {'^' | '>' | 'v' | '<'} Arrow */
+export const /** @type {readonly Arrow[]} */ ARROWS = ["^", ">", "v", "<"];
+
+/* Cell values of the flat grid. */
+export const FLOOR = 0;
+export const OBSTACLE = 1;
+
+/** Jump target meaning the guard walks off the map. */
+export const EXIT = -1;
+
+/**
+ * @typedef {object} Lab
+ * @property {Uint8Array} grid FLOOR or OBSTACLE, row-major
+ * @property {number} rows_size
+ * @property {number} cols_size
+ * @property {number} start_cell
+ * @property {Direction} start_facing
+ */
+
+/**
+ * @param {string} input
+ * @returns {Lab}
+ */
+export function parse_input(input) {
+  const lines = input.trim().split("\n");
+  const rows_size = lines.length, cols_size = lines[0].length;
+  const grid = new Uint8Array(rows_size * cols_size);
+  let start_cell = -1, start_facing = NORTH;
+
+  for (let row = 0; row < rows_size; ++row) {
+    for (let col = 0; col < cols_size; ++col) {
+      const cell = row * cols_size + col;
+      const char = lines[row][col];
+      if (char === "#") {
+        grid[cell] = OBSTACLE;
+      } else if (ARROWS.includes(char)) {
+        start_cell = cell;
+        start_facing = /** @type {Direction} */ (ARROWS.indexOf(char));
+      }
+    }
+  }
+  if (start_cell === -1) throw new Error("no guard on the map");
+
+  return { grid, rows_size, cols_size, start_cell, start_facing };
+}
+
+/**
+ * @param {Direction} facing
+ * @returns {Direction}
+ */
+export function turn_90_degrees(facing) {
+  return /** @type {Direction} */ ((facing + 1) % ARROWS.length);
+}
+
+/**
+ * For every cell and direction, the cell the guard stops on in front of the
+ * next obstacle, or EXIT if nothing is in the way.  Indexed by
+ * `(row * cols + col) * 4 + facing`, and backed by shared memory so the
+ * loop search workers can read it without a copy.
+ *
+ * @param {Lab} lab
+ */
+export function build_jump_table({ grid, rows_size, cols_size }) {
+  const table = new Int32Array(
+    new SharedArrayBuffer(rows_size * cols_size * 4 * 4),
+  );
+
+  /**
+   * Walk one line of cells against the direction of travel, so the stop
+   * for each cell is already known when it is reached.
+   *
+   * @param {Direction} facing
+   * @param {number} first
+   * @param {number} step
+   * @param {number} count
+   */
+  const fill_line = (facing, first, step, count) => {
+    let stop = EXIT, blocked = false;
+    for (let i = 0, cell = first; i < count; ++i, cell += step) {
+      if (grid[cell] === OBSTACLE) {
+        blocked = true;
+        continue;
+      }
+      if (blocked) {
+        stop = cell;
+        blocked = false;
+      }
+      table[cell * 4 + facing] = stop;
+    }
+  };
+
+  const last_row = (rows_size - 1) * cols_size;
+  for (let col = 0; col < cols_size; ++col) {
+    fill_line(NORTH, col, cols_size, rows_size);
+    fill_line(SOUTH, last_row + col, -cols_size, rows_size);
+  }
+  for (let row = 0; row < rows_size; ++row) {
+    fill_line(WEST, row * cols_size, 1, cols_size);
+    fill_line(EAST, row * cols_size + cols_size - 1, -1, cols_size);
+  }
+
+  return table;
+}
+
+/**
+ * Where the guard stops when walking from `cell`, taking an extra
+ * obstruction into account on top of the jump table.
+ *
+ * @param {Int32Array} table
+ * @param {number} cols_size
+ * @param {number} cell
+ * @param {Direction} facing
+ * @param {number} obstruction cell index, or -1 for none
+ */
+export function next_stop(table, cols_size, cell, facing, obstruction) {
+  const stop = table[cell * 4 + facing];
+  if (obstruction < 0) return stop;
+
+  const row = Math.floor(cell / cols_size), col = cell % cols_size;
+  const o_row = Math.floor(obstruction / cols_size);
+  const o_col = obstruction % cols_size;
+  const stop_row = Math.floor(stop / cols_size), stop_col = stop % cols_size;
+
+  switch (facing) {
+    case NORTH:
+      if (o_col !== col || o_row >= row) return stop;
+      return stop === EXIT || o_row >= stop_row ? obstruction + cols_size : stop;
+    case SOUTH:
+      if (o_col !== col || o_row <= row) return stop;
+      return stop === EXIT || o_row <= stop_row ? obstruction - cols_size : stop;
+    case EAST:
+      if (o_row !== row || o_col <= col) return stop;
+      return stop === EXIT || o_col <= stop_col ? obstruction - 1 : stop;
+    case WEST:
+      if (o_row !== row || o_col >= col) return stop;
+      return stop === EXIT || o_col >= stop_col ? obstruction + 1 : stop;
+    default:
+      throw new Error("unreachable");
+  }
+}
+
+/**
+ * Turn states already seen by the current simulation.  A state is marked
+ * with the simulation's generation, so starting the next one needs no
+ * clearing.
+ */
+export class StateSet {
+  /** @param {number} cells */
+  constructor(cells) {
+    this.stamps = new Uint32Array(cells * 4);
+    this.generation = 0;
+  }
+
+  next_generation() {
+    if (++this.generation > 0xFFFFFFFF) {
+      this.stamps.fill(0);
+      this.generation = 1;
+    }
+  }
+
+  /**
+   * Mark a state, returning whether it was already marked.
+   *
+   * @param {number} cell
+   * @param {Direction} facing
+   */
+  test_and_set(cell, facing) {
+    const state = cell * 4 + facing;
+    if (this.stamps[state] === this.generation) return true;
+    this.stamps[state] = this.generation;
+    return false;
+  }
+}
+
+/**
+ * @param {Int32Array} table
+ * @param {number} cols_size
+ * @param {StateSet} visited
+ * @param {number} start_cell
+ * @param {Direction} start_facing
+ * @param {number} obstruction
+ */
+export function simulate_path(
+  table,
+  cols_size,
+  visited,
+  start_cell,
+  start_facing,
+  obstruction,
+) {
+  let cell = start_cell, facing = start_facing;
+
+  visited.next_generation();
+  while (true) {
+    const stop = next_stop(table, cols_size, cell, facing, obstruction);
+    if (stop === EXIT) return false;
+    if (visited.test_and_set(stop, facing)) return true;
+
+    cell = stop;
+    facing = turn_90_degrees(facing);
+  }
+}
+
+/** Candidate obstructions a worker claims at a time. */
+const CANDIDATE_CHUNK = 64;
+
+/**
+ * @typedef {object} LoopSearch
+ * @property {Int32Array} table jump table from build_jump_table
+ * @property {number} cols_size
+ * @property {Int32Array} candidates cells to put the obstruction on
+ * @property {Int32Array} starts `cell * 4 + facing` of the guard just before
+ *   it first reaches the matching candidate
+ * @property {Int32Array} cursor next unclaimed candidate, shared by workers
+ */
+
+/**
+ * Try candidates until none are left, claiming them in chunks from the
+ * shared cursor.  Returns how many of them trap the guard in a loop.
+ *
+ * @param {LoopSearch} search
+ */
+export function count_loops({ table, cols_size, candidates, starts, cursor }) {
+  const visited = new StateSet(table.length / 4);
+  let loops = 0;
+
+  while (true) {
+    const first = Atomics.add(cursor, 0, CANDIDATE_CHUNK);
+    if (first >= candidates.length) break;
+
+    const last = Math.min(first + CANDIDATE_CHUNK, candidates.length);
+    for (let i = first; i < last; ++i) {
+      const cell = starts[i] >> 2;
+      const facing = /** @type {Direction} */ (starts[i] & 3);
+      if (simulate_path(table, cols_size, visited, cell, facing, candidates[i])) {
+        ++loops;
+      }
+    }
+  }
+
+  return loops;
+}
@@ -1,220 +1,137 @@
-const input = Deno.readTextFileSync("input.txt");
+import {
+  build_jump_table,
+  count_loops,
+  EXIT,
+  parse_input,
+  turn_90_degrees,
+} from "./guard.js";
+import { readInput } from "../lib/input.js";
+import { phase, phaseAsync } from "../lib/phase.js";
+
+/* Below this many candidates per worker, spawning one costs more than it saves. */
+const MIN_CANDIDATES_PER_WORKER = 1024;
 
 /**
- * @template T, U
- * @typedef {(acc: T, curr: U, index: number) => T} ReducerFn
+ * @param {import("./guard.js").LoopSearch} search
+ * @param {number} nworkers
+ * @returns {Promise<number>}
  */
-
-/** @typedef {0 | 1 | 2 | 3} Direction */
-const /** @type {Direction} */ NORTH = 0;
-const /** @type {Direction} */ EAST = 1;
-const /** @type {Direction} */ SOUTH = 2;
-const /** @type {Direction} */ WEST = 3;
-
-/** @typedef {'^' | '>' | 'v' | '<'} Arrow */
-const /** @type {readonly Arrow[]} */ ARROWS = ["^", ">", "v", "<"];
-
-/**
- * @param {string} input
- * @returns {[string[][], number]}
- */
-function parse_input(input) {
-  const rows = input.split("\n").map((row) => row.split(""));
-  return [rows, rows.length];
+function count_loops_in_workers(search, nworkers) {
+  const url = new URL("./worker.js", import.meta.url).href;
+  const counts = Array.from({ length: nworkers }, () =>
+    new Promise((resolve, reject) => {
+      const worker = new Worker(url, { type: "module" });
+      worker.onmessage = (event) => resolve(event.data);
+      worker.onerror = (event) => reject(event.error ?? event);
+      worker.postMessage(search);
+    }));
+  return Promise.all(counts).then((counts) =>
+    counts.reduce((sum, count) => sum + count, 0)
+  );
 }
 
-/**
- * @param {Arrow} arrow
+const ROW_STEP = [-1, 0, 1, 0];
+const COL_STEP = [0, 1, 0, -1];
+
+/*
+ * Walk the patrol, counting the distinct cells the guard steps on.  Also
+ * remember, for every cell the guard walks onto, where they stood and which
+ * way they faced just before.  Those cells are the only useful places for
+ * the part 2 obstruction, and the search for each can resume from there.
+ *
+ * @param {import("./guard.js").Lab} lab
+ * @param {Int32Array} table
  */
-function arrow_facing(arrow) {
-  switch (arrow) {
-    case ARROWS[NORTH]:
-      return NORTH;
-    case ARROWS[EAST]:
-      return EAST;
-    case ARROWS[SOUTH]:
-      return SOUTH;
-    case ARROWS[WEST]:
-      return WEST;
-    default:
-      throw new Error("unreachable");
-  }
-}
-
-/**
- * @param {Arrow} arrow
- */
-function turn_arrow_90_degrees(arrow) {
-  return ARROWS[(arrow_facing(arrow) + 1) % ARROWS.length];
-}
-
-/**
- * @param {string[][]} rows
- */
-function find_arrow_coords(rows) {
-  /** @type {ReducerFn<[number, number], string[]>} */
-  const find_by_arrow = (acc, row, index) => {
-    const guardian_found = row.findIndex((char) => ARROWS.includes(char));
-    if (guardian_found !== -1) return [index, guardian_found];
-    return acc;
-  };
-  const coords = rows.reduce(find_by_arrow, [-1, -1]);
-  return coords;
-}
-
-/**
- * @param {string[][]} rows
- * @param {[number, number]} coords
- * @returns {["#" | "." | "X", [number, number]] | null}
- */
-function look_around(rows, coords) {
-  const [guardian_row, guardian_col] = coords;
-  const guardian = rows[guardian_row][guardian_col];
-  let next_row, next_col;
-
-  const guardian_facing = arrow_facing(guardian);
-  switch (guardian_facing) {
-    case NORTH:
-      next_row = guardian_row - 1;
-      next_col = guardian_col;
-      break;
-    case EAST:
-      next_row = guardian_row;
-      next_col = guardian_col + 1;
-      break;
-    case SOUTH:
-      next_row = guardian_row + 1;
-      next_col = guardian_col;
-      break;
-    case WEST:
-      next_row = guardian_row;
-      next_col = guardian_col - 1;
-      break;
-    default:
-      throw new Error("unreachable");
-  }
+function walk_patrol({ rows_size, cols_size, start_cell, start_facing }, table) {
+  const seen = new Uint8Array(rows_size * cols_size);
+  const candidates = new Int32Array(new SharedArrayBuffer(seen.length * 4));
+  const starts = new Int32Array(new SharedArrayBuffer(seen.length * 4));
+  let steps = 0;
+
+  let guardian_row = Math.floor(start_cell / cols_size);
+  let guardian_col = start_cell % cols_size;
+  for (let facing = start_facing;; facing = turn_90_degrees(facing)) {
+    const stop = table[(guardian_row * cols_size + guardian_col) * 4 + facing];
+
+    let previous = -1;
+    while (true) {
+      const cell = guardian_row * cols_size + guardian_col;
+      if (!seen[cell]) {
+        seen[cell] = 1;
+        if (cell !== start_cell) {
+          candidates[steps - 1] = cell;
+          starts[steps - 1] = previous * 4 + facing;
+        }
+        ++steps;
+      }
+      if (cell === stop) break;
+
+      previous = cell;
+      const next_row = guardian_row + ROW_STEP[facing];
+      const next_col = guardian_col + COL_STEP[facing];
+      if (
+        next_row < 0 || next_row >= rows_size ||
+        next_col < 0 || next_col >= cols_size
+      ) {
+        break;
+      }
+      guardian_row = next_row;
+      guardian_col = next_col;
+    }
 
-  if (
-    next_row < 0 || next_row >= rows_size ||
-    next_col < 0 || next_col >= rows_size
-  ) {
-    return null;
+    if (stop === EXIT) break;
   }
 
-  const next_symbol = rows[next_row][next_col];
-  switch (next_symbol) {
-    case "#":
-    case ".":
-    case "X":
-      return [next_symbol, [next_row, next_col]];
-    default:
-      return null;
-  }
+  return {
+    steps,
+    candidates: candidates.subarray(0, steps - 1),
+    starts: starts.subarray(0, steps - 1),
+  };
 }
 
 /**
- * @param {string[][]} test_rows
- * @param {[number, number]} start_coords
+ * Solve both parts, appending the time of every phase to times if given.
+ * @param {string} input
+ * @param {{ name: string, ns: number }[]} [times]
  */
-function simulate_path(test_rows, start_coords) {
-  let [guardian_row, guardian_col] = start_coords;
-
-  const visited = new Set();
-  while (true) {
-    const current_arrow = test_rows[guardian_row][guardian_col];
-    const state = `${guardian_row},${guardian_col},${current_arrow}`;
-
-    if (visited.has(state)) {
-      return true;
-    }
-    if (visited.size > test_rows.length ** 2 * 4) {
-      return false;
-    }
-    visited.add(state);
-
-    const looked_around = look_around(test_rows, [guardian_row, guardian_col]);
-    if (!looked_around) return false;
-
-    const [next_symbol, [next_row, next_col]] = looked_around;
-    switch (next_symbol) {
-      case "#":
-        {
-          const next_arrow = turn_arrow_90_degrees(current_arrow);
-          test_rows[guardian_row][guardian_col] = next_arrow;
-        }
-        break;
-      case ".":
-        test_rows[guardian_row][guardian_col] = ".";
-        test_rows[next_row][next_col] = current_arrow;
-        guardian_row = next_row;
-        guardian_col = next_col;
-        break;
-      default:
-        return false;
-    }
-  }
-}
+export async function solve(input, times) {
+  const [lab, table] = phase("parse", () => {
+    const lab = parse_input(input);
+    return [lab, build_jump_table(lab)];
+  }, times);
 
-/* part 1 */
+  /* part 1 */
 
-let [rows, rows_size] = parse_input(input);
-const guardian_coords = find_arrow_coords(rows);
+  const patrol = phase("part1", () => walk_patrol(lab, table), times);
 
-for (
-  let [guardian_row, guardian_col] = guardian_coords,
-    looked_around = look_around(rows, guardian_coords);;
-  [guardian_row, guardian_col] = find_arrow_coords(rows),
-    looked_around = look_around(rows, [guardian_row, guardian_col])
-) {
-  if (!looked_around) {
-    rows[guardian_row][guardian_col] = "X";
-    break;
-  }
+  /* part 2 */
 
-  const /** @type {Arrow} */ current_arrow = rows[guardian_row][guardian_col];
-  const [next_symbol, [next_row, next_col]] = looked_around;
-  switch (next_symbol) {
-    case "#":
-      rows[guardian_row][guardian_col] = turn_arrow_90_degrees(current_arrow);
-      break;
-    case ".":
-    case "X":
-      rows[guardian_row][guardian_col] = "X";
-      rows[next_row][next_col] = current_arrow;
-      break;
-    default:
-      throw new Error("unreachable");
-  }
+  const search = {
+    table,
+    cols_size: lab.cols_size,
+    candidates: patrol.candidates,
+    starts: patrol.starts,
+    cursor: new Int32Array(new SharedArrayBuffer(4)),
+  };
+  const nworkers = Math.min(
+    navigator.hardwareConcurrency ?? 1,
+    Math.ceil(search.candidates.length / MIN_CANDIDATES_PER_WORKER),
+  );
+
+  const loop_count = await phaseAsync(
+    "part2",
+    () =>
+      nworkers > 1
+        ? count_loops_in_workers(search, nworkers)
+        : count_loops(search),
+    times,
+  );
+
+  return { part1: patrol.steps, part2: loop_count };
 }
 
-console.log(
-  `number of steps =\n\t${
-    rows.flatMap((row) => row.join("")).join("").match(/X/g).length
-  }`,
-);
-
-/* part 2 */
-
-[rows, rows_size] = parse_input(input);
-const [start_guardian_row, start_guardian_col] = find_arrow_coords(rows);
-
-let loop_count = 0;
-for (let row = 0; row < rows_size; ++row) {
-  for (let col = 0; col < rows_size; ++col) {
-    if (
-      rows[row][col] !== "." ||
-      (row === start_guardian_row && col === start_guardian_col)
-    ) {
-      continue;
-    }
-
-    const test_rows = structuredClone(rows);
-    test_rows[row][col] = "#";
-
-    if (simulate_path(test_rows, [start_guardian_row, start_guardian_col])) {
-      ++loop_count;
-    }
-  }
+if (import.meta.main) {
+  const { part1, part2 } = await solve(await readInput());
+  console.log(`number of steps =\n\t${part1}`);
+  console.log(`number of loops =\n\t${part2}`);
 }
-
-console.log(`number of loops =\n\t${loop_count}`);
@@ -0,0 +1,7 @@
+import { count_loops } from "./guard.js";
+
+/** @param {MessageEvent<import("./guard.js").LoopSearch>} event */
+self.onmessage = (event) => {
+  self.postMessage(count_loops(event.data));
+  self.close();
+};
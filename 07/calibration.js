@@ -0,0 +1,199 @@
+/* Equation parsing and solving shared by main.js and the batch workers. */
+
+/*
+ * Values above this are not exact as Numbers.  The backward search only
+ * ever makes values smaller, so an equation whose test value and operands
+ * are all at or below it can be solved with Numbers; anything larger goes
+ * through the BigInt solver.
+ */
+const MAX_EXACT = BigInt(Number.MAX_SAFE_INTEGER);
+
+/* Numbers with more digits than this may not be exact and are parsed as BigInt. */
+const MAX_EXACT_DIGITS = 15;
+
+/* Equations a worker claims at a time. */
+const EQUATION_CHUNK = 256;
+
+/*
+ * Work backwards from the test value: the last operand must have been
+ * added, multiplied or concatenated onto whatever the operands before it
+ * produced, so undo each operator where that is possible and recurse.
+ * Undoing fails far more often than not, which prunes most of the tree.
+ * The operands are numbers[first..index], and `x || n` is
+ * `x * shifts[i] + n`, with shifts[i] the power of ten above n.
+ */
+function canReach(target, numbers, shifts, first, index, withConcat) {
+  const n = numbers[index];
+  if (index === first) {
+    return target === n;
+  }
+
+  if (n !== 0 && target % n === 0 &&
+    canReach(target / n, numbers, shifts, first, index - 1, withConcat)) {
+    return true;
+  }
+
+  if (withConcat && target >= n && (target - n) % shifts[index] === 0 &&
+    canReach((target - n) / shifts[index], numbers, shifts, first, index - 1, true)) {
+    return true;
+  }
+
+  return target >= n &&
+    canReach(target - n, numbers, shifts, first, index - 1, withConcat);
+}
+
+/* canReach for equations that do not fit in a Number. */
+function canReachBig(target, numbers, shifts, first, index, withConcat) {
+  const n = numbers[index];
+  if (index === first) {
+    return target === n;
+  }
+
+  if (n !== 0n && target % n === 0n &&
+    canReachBig(target / n, numbers, shifts, first, index - 1, withConcat)) {
+    return true;
+  }
+
+  if (withConcat && target >= n && (target - n) % shifts[index] === 0n &&
+    canReachBig((target - n) / shifts[index], numbers, shifts, first, index - 1, true)) {
+    return true;
+  }
+
+  return target >= n &&
+    canReachBig(target - n, numbers, shifts, first, index - 1, withConcat);
+}
+
+export function canSolveEquation(equation, withConcat) {
+  const { testValue, numbers, shifts } = equation;
+  const solve = typeof testValue === "bigint" ? canReachBig : canReach;
+  return numbers.length > 0 &&
+    solve(testValue, numbers, shifts, 0, numbers.length - 1, withConcat);
+}
+
+export function parseEquation(line) {
+  const [testValueStr, numbersStr] = line.split(": ");
+  const testValue = BigInt(testValueStr);
+  const numbers = numbersStr.trim().split(" ").map((n) => BigInt(n));
+  const shifts = numbers.map((n) => 10n ** BigInt(n.toString().length));
+
+  if (testValue <= MAX_EXACT && numbers.every((n) => n <= MAX_EXACT)) {
+    return {
+      testValue: Number(testValue),
+      numbers: numbers.map(Number),
+      shifts: shifts.map(Number),
+    };
+  }
+  return { testValue, numbers, shifts };
+}
+
+function sharedArray(Type, length) {
+  return new Type(new SharedArrayBuffer(length * Type.BYTES_PER_ELEMENT));
+}
+
+/*
+ * Parse a whole calibration file in one scan.  Equations whose numbers all
+ * fit in MAX_EXACT_DIGITS go into shared typed arrays: the operands of
+ * equation i are operands[offsets[i]..offsets[i + 1]).  The rare wider
+ * equations are returned as lines for parseEquation.
+ */
+export function parseBatch(input) {
+  let lines = 1, spaces = 0;
+  for (let i = 0; i < input.length; ++i) {
+    const c = input.charCodeAt(i);
+    if (c === 10) ++lines;
+    else if (c === 32) ++spaces;
+  }
+
+  const targets = sharedArray(Float64Array, lines);
+  const offsets = sharedArray(Uint32Array, lines + 1);
+  const operands = sharedArray(Float64Array, spaces);
+  const shifts = sharedArray(Float64Array, spaces);
+  const wide = [];
+  let count = 0, noperands = 0;
+
+  for (let pos = 0; pos < input.length;) {
+    const start = pos;
+    let end = input.indexOf("\n", pos);
+    if (end === -1) end = input.length;
+    pos = end + 1;
+
+    let value = 0, digits = 0, i = start;
+    for (; i < end && input.charCodeAt(i) !== 58; ++i) {
+      value = value * 10 + input.charCodeAt(i) - 48;
+      ++digits;
+    }
+    if (i === end) continue;
+    let exact = digits <= MAX_EXACT_DIGITS;
+    targets[count] = value;
+    offsets[count] = noperands;
+
+    for (++i; i < end && exact; ++i) {
+      const c = input.charCodeAt(i);
+      if (c < 48 || c > 57) continue;
+
+      let shift = 1;
+      value = 0;
+      digits = 0;
+      for (; i < end; ++i) {
+        const d = input.charCodeAt(i) - 48;
+        if (d < 0 || d > 9) break;
+        value = value * 10 + d;
+        shift *= 10;
+        ++digits;
+      }
+      exact = digits <= MAX_EXACT_DIGITS;
+      operands[noperands] = value;
+      shifts[noperands] = shift;
+      ++noperands;
+    }
+
+    if (exact) {
+      ++count;
+    } else {
+      noperands = offsets[count];
+      wide.push(input.slice(start, end));
+    }
+  }
+  offsets[count] = noperands;
+
+  return {
+    batch: {
+      targets: targets.subarray(0, count),
+      offsets: offsets.subarray(0, count + 1),
+      operands,
+      shifts,
+      cursor: sharedArray(Int32Array, 1),
+    },
+    wide,
+  };
+}
+
+/*
+ * Check equations from the batch until none are left, claiming them in
+ * chunks from the shared cursor.  Anything solvable with (+, *) is also
+ * solvable with (+, *, ||), so the second search only runs on failures.
+ * Returns both totals as BigInts.
+ */
+export function calibrate({ targets, offsets, operands, shifts, cursor }) {
+  let total = 0n, totalWithConcat = 0n;
+
+  while (true) {
+    const first = Atomics.add(cursor, 0, EQUATION_CHUNK);
+    if (first >= targets.length) break;
+
+    const last = Math.min(first + EQUATION_CHUNK, targets.length);
+    for (let i = first; i < last; ++i) {
+      const from = offsets[i], to = offsets[i + 1] - 1;
+      if (to < from) continue;
+
+      if (canReach(targets[i], operands, shifts, from, to, false)) {
+        total += BigInt(targets[i]);
+        totalWithConcat += BigInt(targets[i]);
+      } else if (canReach(targets[i], operands, shifts, from, to, true)) {
+        totalWithConcat += BigInt(targets[i]);
+      }
+    }
+  }
+
+  return [total, totalWithConcat];
+}
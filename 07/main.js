@@ -1,126 +1,63 @@
-const input = Deno.readTextFileSync("input.txt");
-
-function evaluateExpression(numbers, operators) {
-  let result = numbers[0];
-  for (let i = 0; i < operators.length; ++i) {
-    switch (operators[i]) {
-      case "+":
-        result += numbers[i + 1];
-        break;
-      case "*":
-        result *= numbers[i + 1];
-        break;
-      default:
-        throw new Error("unreachable");
-    }
-  }
-  return result;
-}
-
-function evaluateExpression2(numbers, operators) {
-  let result = numbers[0];
-  for (let i = 0; i < operators.length; ++i) {
-    switch (operators[i]) {
-      case "+":
-        result += numbers[i + 1];
-        break;
-      case "*":
-        result *= numbers[i + 1];
-        break;
-      case "||":
-        result = parseInt(result.toString() + numbers[i + 1].toString());
-        break;
-      default:
-        throw new Error("unreachable");
-    }
-  }
-  return result;
-}
-
-function generateOperatorCombinations(length) {
-  const operators = ["+", "*"];
-  const combinations = [];
-
-  function generate(current) {
-    if (current.length === length) {
-      combinations.push([...current]);
-      return;
-    }
-    for (const op of operators) {
-      current.push(op);
-      generate(current);
-      current.pop();
-    }
-  }
-
-  generate([]);
-  return combinations;
-}
-
-function generateOperatorCombinations2(length) {
-  const operators = ["+", "*", "||"];
-  const combinations = [];
-
-  function generate(current) {
-    if (current.length === length) {
-      combinations.push([...current]);
-      return;
-    }
-    for (const op of operators) {
-      current.push(op);
-      generate(current);
-      current.pop();
-    }
-  }
-
-  generate([]);
-  return combinations;
-}
-
-function canSolveEquation(testValue, numbers) {
-  const numOperators = numbers.length - 1;
-  const operatorCombinations = generateOperatorCombinations(numOperators);
-
-  for (const operators of operatorCombinations) {
-    if (evaluateExpression(numbers, operators) === testValue) {
-      return true;
-    }
-  }
-  return false;
-}
-
-function canSolveEquation2(testValue, numbers) {
-  const numOperators = numbers.length - 1;
-  const operatorCombinations = generateOperatorCombinations2(numOperators);
-
-  for (const operators of operatorCombinations) {
-    if (evaluateExpression2(numbers, operators) === testValue) {
-      return true;
-    }
-  }
-  return false;
-}
-
-const equations = input.trim().split("\n").map((line) => {
-  const [testValue, numbersStr] = line.split(": ");
-  return {
-    testValue: parseInt(testValue),
-    numbers: numbersStr.split(" ").map((n) => parseInt(n)),
-  };
-});
-
-let totalCalibration = 0;
-for (const equation of equations) {
-  if (canSolveEquation(equation.testValue, equation.numbers)) {
-    totalCalibration += equation.testValue;
-  }
-}
-console.log(`total calibration result (+, *) =\n\t${totalCalibration}`);
-
-totalCalibration = 0;
-for (const equation of equations) {
-  if (canSolveEquation2(equation.testValue, equation.numbers)) {
-    totalCalibration += equation.testValue;
-  }
+import {
+  calibrate,
+  canSolveEquation,
+  parseBatch,
+  parseEquation,
+} from "./calibration.js";
+import { readInput } from "../lib/input.js";
+import { phase, phaseAsync } from "../lib/phase.js";
+
+/* Below this many equations per worker, spawning one costs more than it saves. */
+const MIN_EQUATIONS_PER_WORKER = 16384;
+
+function calibrateInWorkers(batch, workerCount) {
+  const url = new URL("./worker.js", import.meta.url).href;
+  const totals = Array.from({ length: workerCount }, () =>
+    new Promise((resolve, reject) => {
+      const worker = new Worker(url, { type: "module" });
+      worker.onmessage = (event) => resolve(event.data);
+      worker.onerror = (event) => reject(event.error ?? event);
+      worker.postMessage(batch);
+    }));
+  return Promise.all(totals).then((totals) =>
+    totals.reduce(([a, b], [c, d]) => [a + c, b + d], [0n, 0n])
+  );
+}
+
+/* Solve both parts, appending the time of every phase to times if given. */
+export async function solve(input, times) {
+  const { batch, wide } = phase("parse", () => parseBatch(input), times);
+  const workerCount = Math.min(
+    navigator.hardwareConcurrency ?? 1,
+    Math.ceil(batch.targets.length / MIN_EQUATIONS_PER_WORKER),
+  );
+
+  /* Both totals come out of the same pass over the equations. */
+  const [totalCalibration, totalCalibration2] = await phaseAsync(
+    "parts",
+    async () => {
+      let [total, total2] = workerCount > 1
+        ? await calibrateInWorkers(batch, workerCount)
+        : calibrate(batch);
+
+      for (const equation of wide.map(parseEquation)) {
+        if (canSolveEquation(equation, false)) {
+          total += BigInt(equation.testValue);
+          total2 += BigInt(equation.testValue);
+        } else if (canSolveEquation(equation, true)) {
+          total2 += BigInt(equation.testValue);
+        }
+      }
+      return [total, total2];
+    },
+    times,
+  );
+
+  return { part1: totalCalibration, part2: totalCalibration2 };
+}
+
+if (import.meta.main) {
+  const { part1, part2 } = await solve(await readInput());
+  console.log(`total calibration result (+, *) =\n\t${part1}`);
+  console.log(`total calibration result (+, *, ||) =\n\t${part2}`);
 }
-console.log(`total calibration result (+, *, ||) =\n\t${totalCalibration}`);
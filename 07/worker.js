@@ -0,0 +1,6 @@
+import { calibrate } from "./calibration.js";
+
+self.onmessage = (event) => {
+  self.postMessage(calibrate(event.data));
+  self.close();
+};
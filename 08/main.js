@@ -1,4 +1,5 @@
-const input = Deno.readTextFileSync("input.txt");
+import { readInput } from "../lib/input.js";
+import { phase } from "../lib/phase.js";
 
 function findAntennas(grid) {
   const antennas = new Map();
@@ -16,105 +17,119 @@ function findAntennas(grid) {
   return antennas;
 }
 
-function arePointsAligned(p1, p2, p3) {
-  const dx1 = p2.x - p1.x;
-  const dy1 = p2.y - p1.y;
-  const dx2 = p3.x - p2.x;
-  const dy2 = p3.y - p2.y;
-
-  return dx1 * dy2 === dx2 * dy1;
-}
-
-function getDistance(p1, p2) {
-  const dx = p2.x - p1.x;
-  const dy = p2.y - p1.y;
-  return Math.sqrt(dx * dx + dy * dy);
+function isInGrid(x, y, gridSize) {
+  return x >= 0 && x < gridSize.width && y >= 0 && y < gridSize.height;
 }
 
-function findAntinodesBetweenAntennas(ant1, ant2, gridSize) {
-  const antinodes = [];
-
-  for (let y = 0; y < gridSize.height; ++y) {
-    for (let x = 0; x < gridSize.width; ++x) {
-      const point = { x, y };
-
-      if (!arePointsAligned(ant1, point, ant2)) continue;
-
-      const d1 = getDistance(ant1, point);
-      const d2 = getDistance(ant2, point);
+/* Set of grid cells, one byte per cell, with a running count. */
+class AntinodeSet {
+  constructor(gridSize) {
+    this.width = gridSize.width;
+    this.cells = new Uint8Array(gridSize.width * gridSize.height);
+    this.size = 0;
+  }
 
-      const ratio = Math.max(d1, d2) / Math.min(d1, d2);
-      if (Math.abs(ratio - 2) < 0.0001) {
-        antinodes.push(point);
-      }
+  add(x, y) {
+    const index = y * this.width + x;
+    if (this.cells[index] === 0) {
+      this.cells[index] = 1;
+      ++this.size;
     }
   }
+}
 
-  return antinodes;
+function gcd(a, b) {
+  a = Math.abs(a);
+  b = Math.abs(b);
+  while (b !== 0) {
+    [a, b] = [b, a % b];
+  }
+  return a;
 }
 
-function findAntinodes2(ant1, ant2, gridSize) {
-  const antinodes = [];
+function addIfInGrid(antinodes, x, y, gridSize) {
+  if (isInGrid(x, y, gridSize)) {
+    antinodes.add(x, y);
+  }
+}
 
-  antinodes.push({ ...ant1 });
-  antinodes.push({ ...ant2 });
+/*
+ * Points in line with both antennas where one antenna is twice as far away
+ * as the other: one beyond each antenna, plus the two points that split the
+ * pair into thirds when those land on the grid.
+ */
+function findAntinodesBetweenAntennas(ant1, ant2, gridSize, antinodes) {
+  const dx = ant2.x - ant1.x;
+  const dy = ant2.y - ant1.y;
+
+  addIfInGrid(antinodes, ant1.x - dx, ant1.y - dy, gridSize);
+  addIfInGrid(antinodes, ant2.x + dx, ant2.y + dy, gridSize);
+
+  if (dx % 3 === 0 && dy % 3 === 0) {
+    addIfInGrid(antinodes, ant1.x + dx / 3, ant1.y + dy / 3, gridSize);
+    addIfInGrid(antinodes, ant2.x - dx / 3, ant2.y - dy / 3, gridSize);
+  }
+}
 
-  for (let y = 0; y < gridSize.height; ++y) {
-    for (let x = 0; x < gridSize.width; ++x) {
-      const point = { x, y };
-      if (arePointsAligned(ant1, point, ant2)) {
-        antinodes.push(point);
-      }
-    }
+/* Every grid point on the line through both antennas. */
+function findAntinodes2(ant1, ant2, gridSize, antinodes) {
+  const divisor = gcd(ant2.x - ant1.x, ant2.y - ant1.y);
+  const stepX = (ant2.x - ant1.x) / divisor;
+  const stepY = (ant2.y - ant1.y) / divisor;
+
+  for (let x = ant1.x, y = ant1.y; isInGrid(x, y, gridSize);) {
+    antinodes.add(x, y);
+    x += stepX;
+    y += stepY;
   }
 
-  return antinodes;
+  for (let x = ant1.x - stepX, y = ant1.y - stepY; isInGrid(x, y, gridSize);) {
+    antinodes.add(x, y);
+    x -= stepX;
+    y -= stepY;
+  }
 }
 
-function findAllAntinodes(grid, isPart2 = false) {
-  const antennas = findAntennas(grid);
-  const antinodeSet = new Set();
-  const gridSize = {
-    height: grid.length,
-    width: grid[0].length,
-  };
+/* Both parts' antinode sets from a single pass over the antenna pairs. */
+function findAllAntinodes(antennas, gridSize) {
+  const partOne = new AntinodeSet(gridSize);
+  const partTwo = new AntinodeSet(gridSize);
 
   for (const [_freq, antennaPositions] of antennas.entries()) {
-    if (antennaPositions.length < 2) continue;
-
     for (let i = 0; i < antennaPositions.length - 1; ++i) {
       for (let j = i + 1; j < antennaPositions.length; ++j) {
-        const antinodes = isPart2
-          ? findAntinodes2(antennaPositions[i], antennaPositions[j], gridSize)
-          : findAntinodesBetweenAntennas(
-            antennaPositions[i],
-            antennaPositions[j],
-            gridSize,
-          );
-
-        for (const node of antinodes) {
-          if (
-            node.x >= 0 && node.x < gridSize.width &&
-            node.y >= 0 && node.y < gridSize.height
-          ) {
-            antinodeSet.add(`${node.x},${node.y}`);
-          }
-        }
+        const ant1 = antennaPositions[i], ant2 = antennaPositions[j];
+        findAntinodesBetweenAntennas(ant1, ant2, gridSize, partOne);
+        findAntinodes2(ant1, ant2, gridSize, partTwo);
       }
     }
   }
 
-  return antinodeSet;
+  return [partOne, partTwo];
 }
 
-const grid = input.trim().split("\n").map((line) => line.trim().split(""));
-
-const antinodesPartOne = findAllAntinodes(grid, false);
-console.log(
-  `Number of unique antinode locations (A-frequency) =\n\t${antinodesPartOne.size}`,
-);
+/* Solve both parts, appending the time of every phase to times if given. */
+export function solve(input, times) {
+  const [antennas, gridSize] = phase("parse", () => {
+    const grid = input.trim().split("\n").map((line) => line.trim().split(""));
+    return [findAntennas(grid), { height: grid.length, width: grid[0].length }];
+  }, times);
+
+  /* Both parts come out of the same pass over the antenna pairs. */
+  const [antinodesPartOne, antinodesPartTwo] = phase(
+    "parts",
+    () => findAllAntinodes(antennas, gridSize),
+    times,
+  );
+  return { part1: antinodesPartOne.size, part2: antinodesPartTwo.size };
+}
 
-const antinodesPartTwo = findAllAntinodes(grid, true);
-console.log(
-  `Number of unique antinode locations (T-frequency) =\n\t${antinodesPartTwo.size}`,
-);
+if (import.meta.main) {
+  const { part1, part2 } = solve(await readInput());
+  console.log(
+    `Number of unique antinode locations (A-frequency) =\n\t${part1}`,
+  );
+  console.log(
+    `Number of unique antinode locations (T-frequency) =\n\t${part2}`,
+  );
+}
@@ -1,120 +1,220 @@
-const input = Deno.readTextFileSync("input.txt");
-
-const blocks = new Int32Array(input.length);
-let block_id = 0, blocks_bytelength = 0;
-for (let i = 0; i < input.length; ++i) {
-  const length = parseInt(input[i]);
-  if (isNaN(length)) continue;
-
-  const packed = block_id | (length << 28);
-  blocks[i] = packed;
-  blocks_bytelength += length;
-  if ((i & 1) === 0) ++block_id;
+import { readInput } from "../lib/input.js";
+import { phase } from "../lib/phase.js";
+
+/*
+ * A disk as runs of blocks rather than blocks: run i holds ids[i] for
+ * lengths[i] blocks from starts[i].  Memory grows with the number of runs,
+ * not with the size of the disk.  Files are at most 9 blocks long, but free
+ * runs joined across zero-length files can be longer.
+ */
+function create_runs(capacity) {
+  return {
+    ids: new Uint32Array(capacity),
+    starts: new Float64Array(capacity),
+    lengths: new Uint32Array(capacity),
+    count: 0,
+  };
 }
 
-function format_disk(blocks, blocks_bytelength) {
-  const disk = new Int32Array(blocks_bytelength);
-  for (let i = 0, offset = 0; i < blocks.length; ++i) {
-    const block = blocks[i];
-    const [block_id, block_len] = [block & 0xFFFFFFF, (block >> 28) & 0xF];
-    disk.fill((i & 1) === 0 ? block_id : -1, offset, offset + block_len);
-    offset += block_len;
-  }
-  return disk;
+function push_run(runs, id, start, length) {
+  runs.ids[runs.count] = id;
+  runs.starts[runs.count] = start;
+  runs.lengths[runs.count] = length;
+  ++runs.count;
 }
 
-function is_compacted(disk) {
-  let foundEmpty = false;
-  for (let i = 0; i < disk.length; ++i) {
-    if (disk[i] === -1) {
-      foundEmpty = true;
-    } else {
-      if (foundEmpty) {
-        return false;
+/*
+ * Split the disk map into file runs (id = file number) and free runs.  The
+ * free space on both sides of a zero-length file is one span on the disk,
+ * so it is kept as one run.
+ */
+function parse_disk_map(input) {
+  const capacity = (input.length >> 1) + 1;
+  const files = create_runs(capacity), free = create_runs(capacity);
+
+  for (let i = 0, digit = 0, position = 0; i < input.length; ++i) {
+    const length = input.charCodeAt(i) - 48;
+    if (length < 0 || length > 9) continue;
+
+    if ((digit & 1) === 0) {
+      push_run(files, digit >> 1, position, length);
+    } else if (length > 0) {
+      const last = free.count - 1;
+      if (last >= 0 && free.starts[last] + free.lengths[last] === position) {
+        free.lengths[last] += length;
+      } else {
+        push_run(free, 0, position, length);
       }
     }
+    position += length;
+    ++digit;
   }
-  return true;
+
+  return { files, free };
 }
 
-let disk = format_disk(blocks, blocks_bytelength);
+/* Sum of the positions start, start + 1, ..., start + length - 1. */
+function position_sum(start, length) {
+  return length * (2 * start + length - 1) / 2;
+}
 
-let i = 0, l = 0, r = disk.length - 1;
-while (!is_compacted(disk)) {
-  while (disk[l] >= 0) {
-    ++l;
+function calculate_checksum(runs) {
+  let checksum = 0n;
+  for (let i = 0; i < runs.count; ++i) {
+    checksum += BigInt(runs.ids[i]) *
+      BigInt(position_sum(runs.starts[i], runs.lengths[i]));
   }
+  return checksum;
+}
+
+/*
+ * Move blocks one at a time: walk the free runs from the left, and fill
+ * each with blocks taken from the end of the rightmost file still on the
+ * disk, until no free run is left of that file.  Files before that point
+ * keep their place, so only the moved pieces need new runs.
+ */
+function compact_blocks({ files, free }) {
+  /* Every piece ends a free run or drains a file, on top of the files kept. */
+  const runs = create_runs(2 * files.count + free.count + 1);
+
+  let left = 0, right = files.count - 1;
+  let remaining = right >= 0 ? files.lengths[right] : 0;
+  for (let f = 0; f < free.count && left <= right; ++f) {
+    let position = free.starts[f], space = free.lengths[f];
+    if (position >= files.starts[right]) break;
+
+    for (; left < right && files.starts[left] < position; ++left) {
+      push_run(runs, files.ids[left], files.starts[left], files.lengths[left]);
+    }
 
-  while (disk[r] < 0) {
-    --r;
+    while (space > 0 && left <= right) {
+      if (remaining === 0) {
+        if (--right >= left) remaining = files.lengths[right];
+        continue;
+      }
+      const moved = Math.min(space, remaining);
+      push_run(runs, files.ids[right], position, moved);
+      position += moved;
+      space -= moved;
+      remaining -= moved;
+    }
   }
 
-  if (disk[l] != null || disk[r] != null) {
-    disk[l] = disk[r];
-    disk[r] = -1;
+  for (; left < right; ++left) {
+    push_run(runs, files.ids[left], files.starts[left], files.lengths[left]);
+  }
+  if (left === right && remaining > 0) {
+    push_run(runs, files.ids[right], files.starts[right], remaining);
   }
 
-  ++i, ++l, --r;
+  return runs;
 }
 
-function calculate_checksum(disk) {
-  let checksum = 0;
-  for (let i = 0; i < disk.length; ++i) {
-    if (disk[i] >= 0) {
-      checksum += disk[i] * i;
-    }
+/* Binary min-heap of positions, kept in a plain array. */
+function heap_push(heap, value) {
+  let i = heap.length;
+  heap.push(value);
+  while (i > 0) {
+    const parent = (i - 1) >> 1;
+    if (heap[parent] <= value) break;
+    heap[i] = heap[parent];
+    i = parent;
   }
-  return checksum;
+  heap[i] = value;
 }
 
-console.log(`compaction by blocks =\n\t${calculate_checksum(disk)}`);
+function heap_pop(heap) {
+  const top = heap[0];
+  const last = heap.pop();
+  if (heap.length === 0) return top;
+
+  let i = 0;
+  while (true) {
+    let child = 2 * i + 1;
+    if (child >= heap.length) break;
+    if (child + 1 < heap.length && heap[child + 1] < heap[child]) ++child;
+    if (heap[child] >= last) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+/* Heap of the free runs longer than any file, whatever their length. */
+const LONG_SPAN = 10;
+
+/*
+ * Move whole files.  Free runs are indexed by length, one min-heap of start
+ * positions per length 1..9 and one for longer runs, whose lengths are kept
+ * by start, so the leftmost run that fits a file is the smallest top among
+ * the heaps for lengths at least the file's.  Only the leftover tail of a
+ * used run goes back in; the space a file leaves behind lies to the right
+ * of every file still to move, so it can never be used.
+ */
+function compact_files({ files, free }) {
+  const runs = create_runs(files.count);
+  const free_runs = Array.from({ length: LONG_SPAN + 1 }, () => []);
+  const long_lengths = new Map();
+  const add_free = (start, length) => {
+    if (length >= LONG_SPAN) long_lengths.set(start, length);
+    heap_push(free_runs[Math.min(length, LONG_SPAN)], start);
+  };
+  for (let i = 0; i < free.count; ++i) {
+    add_free(free.starts[i], free.lengths[i]);
+  }
 
-function fetch_files(disk) {
-  const files = new Map();
-  let current_id = null;
-  let start = 0, length = 0;
-  for (let i = 0; i < disk.length; ++i) {
-    if (disk[i] !== current_id) {
-      if (current_id !== null && current_id !== -1) {
-        files.set(current_id, [start, length]);
+  for (let i = files.count - 1; i >= 0; --i) {
+    const length = files.lengths[i];
+    let start = files.starts[i], best = -1;
+
+    for (let span = Math.max(length, 1); span <= LONG_SPAN; ++span) {
+      const heap = free_runs[span];
+      if (
+        heap.length > 0 && heap[0] < start &&
+        (best === -1 || heap[0] < free_runs[best][0])
+      ) {
+        best = span;
       }
-      current_id = disk[i];
-      start = i, length = 1;
-    } else {
-      ++length;
     }
-  }
-  if (current_id !== null && current_id !== -1) {
-    files.set(current_id, [start, length]);
-  }
-  return files;
-}
 
-function find_free_space(disk, file_length) {
-  let start = 0, current_length = 0;
-  for (let i = 0; i < disk.length; ++i) {
-    if (disk[i] === -1) {
-      if (current_length++ === 0) start = i;
-      if (current_length === file_length) return start;
-    } else {
-      current_length = 0;
+    if (best !== -1) {
+      start = heap_pop(free_runs[best]);
+      let space = best;
+      if (best === LONG_SPAN) {
+        space = long_lengths.get(start);
+        long_lengths.delete(start);
+      }
+      if (space > length) add_free(start + length, space - length);
     }
+
+    push_run(runs, files.ids[i], start, length);
   }
-  return -1;
+
+  return runs;
 }
 
-disk = format_disk(blocks, blocks_bytelength);
+/* Solve both parts, appending the time of every phase to times if given. */
+export function solve(input, times) {
+  const disk = phase("parse", () => parse_disk_map(input), times);
 
-const files = fetch_files(disk);
-const file_ids = Array.from(files.keys()).sort((a, b) => b - a);
-for (const file_id of file_ids) {
-  const [file_start, file_length] = files.get(file_id);
-  const pos = find_free_space(disk, file_length);
+  const blocks_checksum = phase(
+    "part1",
+    () => calculate_checksum(compact_blocks(disk)),
+    times,
+  );
 
-  if (pos !== -1 && pos < file_start) {
-    disk.fill(-1, file_start, file_start + file_length);
-    disk.fill(file_id, pos, pos + file_length);
-  }
+  const files_checksum = phase(
+    "part2",
+    () => calculate_checksum(compact_files(disk)),
+    times,
+  );
+
+  return { part1: blocks_checksum, part2: files_checksum };
 }
 
-console.log(`compaction by files =\n\t${calculate_checksum(disk)}`);
+if (import.meta.main) {
+  const { part1, part2 } = solve(await readInput());
+  console.log(`compaction by blocks =\n\t${part1}`);
+  console.log(`compaction by files =\n\t${part2}`);
+}
@@ -1,10 +1,23 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <err.h>
 
-#define MAX_WIDTH	1024
-#define MAX_HEIGHT	1024
+#include "pool.h"
+#include "solve.h"
+
+#define MAX_WIDTH	8192
+
+#define NHEIGHTS	10
+#define MASK_BITS	(CHAR_BIT * sizeof(unsigned long))
+
+/* Fewest trailheads worth handing to a worker at a time. */
+#define TRAILHEAD_GRAIN	8
 
 struct Point {
 	int	x;
@@ -19,30 +32,62 @@ struct Queue {
 	size_t		rear;
 };
 
-static int grid[MAX_HEIGHT][MAX_WIDTH];
-static int height;
-static int width;
+struct Map {
+	int	*heights;	/* row-major, height * width cells */
+	int	height;
+	int	width;
+};
+
+/* Search state reused across trailheads. */
+struct Scratch {
+	unsigned int	*visited;	/* generation stamp per cell */
+	size_t		cells;
+	unsigned int	generation;
+	struct Queue	queue;
+};
+
+/* Grid cells bucketed by height. */
+struct Layers {
+	int	*cells;			/* cell indices (y * width + x) */
+	size_t	start[NHEIGHTS + 1];	/* height h is cells[start[h]..start[h + 1]) */
+};
+
+/* Trailheads shared by the search workers, each with its own scratch. */
+struct Work {
+	const struct Map	*map;
+	const int		*trailheads;
+	struct Scratch		*scratch;	/* one per worker */
+};
 
 static const int dx[] = {0, 1, 0, -1};
 static const int dy[] = {-1, 0, 1, 0};
 
-static void
+static int
 init_queue(struct Queue *q, size_t capacity)
 {
 	q->items = malloc(capacity * sizeof(struct Point));
 	if (q->items == NULL)
-		err(1, "malloc failed");
+		return -1;
 	q->capacity = capacity;
 	q->size = 0;
 	q->front = 0;
 	q->rear = 0;
+	return 0;
 }
 
+static void
+reset_queue(struct Queue *q)
+{
+	q->size = 0;
+	q->front = 0;
+	q->rear = 0;
+}
+
+/* A cell is queued at most once per search, so the queue never fills. */
 static void
 enqueue(struct Queue *q, struct Point p)
 {
-	if (q->size == q->capacity)
-		err(1, "queue overflow");
+	assert(q->size < q->capacity);
 
 	q->items[q->rear] = p;
 	q->rear = (q->rear + 1) % q->capacity;
@@ -54,8 +99,7 @@ dequeue(struct Queue *q)
 {
 	struct Point p;
 
-	if (q->size == 0)
-		err(1, "queue underflow");
+	assert(q->size > 0);
 
 	p = q->items[q->front];
 	q->front = (q->front + 1) % q->capacity;
@@ -64,50 +108,89 @@ dequeue(struct Queue *q)
 }
 
 static int
-count_reachable_nines(int start_x, int start_y)
+init_scratch(struct Scratch *s, size_t cells)
+{
+	if (cells == 0)
+		cells = 1;
+
+	s->queue.items = NULL;
+	s->visited = calloc(cells, sizeof(*s->visited));
+	if (s->visited == NULL)
+		return -1;
+	s->cells = cells;
+	s->generation = 0;
+	return init_queue(&s->queue, cells);
+}
+
+static void
+free_scratch(struct Scratch *s)
+{
+	free(s->visited);
+	free(s->queue.items);
+}
+
+/*
+ * Start a new search: every stamp left over from earlier searches is now
+ * stale, so nothing has to be cleared unless the counter wraps.
+ */
+static void
+next_generation(struct Scratch *s)
+{
+	if (++s->generation == 0) {
+		memset(s->visited, 0, s->cells * sizeof(*s->visited));
+		s->generation = 1;
+	}
+	reset_queue(&s->queue);
+}
+
+static int
+count_reachable_nines(const struct Map *m, struct Scratch *s, int start_x,
+    int start_y)
 {
-	struct Queue queue;
-	int visited[MAX_HEIGHT][MAX_WIDTH];
+	struct Queue *queue = &s->queue;
+	unsigned int *visited = s->visited;
 	int count = 0;
 	int i;
 	struct Point current;
 	struct Point new_point;
 
-	memset(visited, 0, sizeof(visited));
-	init_queue(&queue, (size_t)(height * width));
+	next_generation(s);
 
 	current.x = start_x;
 	current.y = start_y;
-	enqueue(&queue, current);
-	visited[start_y][start_x] = 1;
+	enqueue(queue, current);
+	visited[start_y * m->width + start_x] = s->generation;
 
-	while (queue.size > 0) {
-		current = dequeue(&queue);
+	while (queue->size > 0) {
+		int current_height;
 
-		if (grid[current.y][current.x] == 9)
+		current = dequeue(queue);
+		current_height = m->heights[current.y * m->width + current.x];
+
+		if (current_height == 9)
 			++count;
 
 		for (i = 0; i < 4; ++i) {
 			int new_x = current.x + dx[i];
 			int new_y = current.y + dy[i];
 
-			if (new_x >= 0 && new_x < width && new_y >= 0 && new_y < height &&
-				!visited[new_y][new_x] &&
-				grid[new_y][new_x] == grid[current.y][current.x] + 1) {
+			if (new_x >= 0 && new_x < m->width && new_y >= 0 && new_y < m->height &&
+				visited[new_y * m->width + new_x] != s->generation &&
+				m->heights[new_y * m->width + new_x] == current_height + 1) {
 				new_point.x = new_x;
 				new_point.y = new_y;
-				enqueue(&queue, new_point);
-				visited[new_y][new_x] = 1;
+				enqueue(queue, new_point);
+				visited[new_y * m->width + new_x] = s->generation;
 			}
 		}
 	}
 
-	free(queue.items);
 	return count;
 }
 
 static int
-count_distinct_paths(int x, int y, int current_height, int visited[MAX_HEIGHT][MAX_WIDTH])
+count_distinct_paths(const struct Map *m, struct Scratch *s, int x, int y,
+    int current_height)
 {
 	int paths = 0;
 	int i;
@@ -117,82 +200,452 @@ count_distinct_paths(int x, int y, int current_height, int visited[MAX_HEIGHT][M
 	if (current_height == 9)
 		return 1;
 
-	visited[y][x] = 1;
+	s->visited[y * m->width + x] = s->generation;
 
 	for (i = 0; i < 4; ++i) {
 		new_x = x + dx[i];
 		new_y = y + dy[i];
 
-		if (new_x >= 0 && new_x < width &&
-			new_y >= 0 && new_y < height &&
-			!visited[new_y][new_x] &&
-			grid[new_y][new_x] == current_height + 1) {
-			paths += count_distinct_paths(new_x, new_y, current_height + 1, visited);
+		if (new_x >= 0 && new_x < m->width &&
+			new_y >= 0 && new_y < m->height &&
+			s->visited[new_y * m->width + new_x] != s->generation &&
+			m->heights[new_y * m->width + new_x] == current_height + 1) {
+			paths += count_distinct_paths(m, s, new_x, new_y, current_height + 1);
 		}
 	}
 
-	visited[y][x] = 0;
+	s->visited[y * m->width + x] = 0;
 	return paths;
 }
 
 static int
-count_trails_from_trailhead(int start_x, int start_y)
+count_trails_from_trailhead(const struct Map *m, struct Scratch *s,
+    int start_x, int start_y)
 {
-	int visited[MAX_HEIGHT][MAX_WIDTH];
-
-	memset(visited, 0, sizeof(visited));
-	return count_distinct_paths(start_x, start_y, 0, visited);
+	next_generation(s);
+	return count_distinct_paths(m, s, start_x, start_y, 0);
 }
 
-static void
-read_input(void)
+/*
+ * Returns -1 when a row is empty, the rows differ in length or there is
+ * no memory left, with nothing left allocated.
+ */
+static int
+read_input(FILE *fp, struct Map *m)
 {
 	char line[MAX_WIDTH + 2];
-	size_t len;
+	size_t len, cap;
+	int *heights;
 	int x;
 
-	height = 0;
-	width = 0;
+	m->heights = NULL;
+	m->height = 0;
+	m->width = 0;
+	cap = 0;
 
-	while (fgets(line, sizeof(line), stdin) != NULL) {
+	while (fgets(line, sizeof(line), fp) != NULL) {
 		len = strlen(line);
 		if (len > 0 && line[len - 1] == '\n')
 			line[--len] = '\0';
 
-		if (width == 0)
-			width = (int)len;
-		else if (width != (int)len)
-			errx(1, "inconsistent line length");
+		/* An empty row would leave the map zero cells wide. */
+		if (len == 0)
+			goto fail;
+		if (m->width == 0)
+			m->width = (int)len;
+		else if (m->width != (int)len)
+			goto fail;
+
+		if ((size_t)m->height == cap) {
+			cap = cap == 0 ? 64 : cap * 2;
+			heights = realloc(m->heights,
+			    cap * (size_t)m->width * sizeof(*m->heights));
+			if (heights == NULL)
+				goto fail;
+			m->heights = heights;
+		}
 
-		if (height >= MAX_HEIGHT)
-			errx(1, "input too tall");
+		for (x = 0; x < m->width; ++x)
+			m->heights[m->height * m->width + x] = line[x] - '0';
 
-		for (x = 0; x < width; ++x)
-			grid[height][x] = line[x] - '0';
+		++m->height;
+	}
+	return 0;
 
-		++height;
+fail:
+	free(m->heights);
+	m->heights = NULL;
+	return -1;
+}
+
+static int
+build_layers(const struct Map *m, struct Layers *l)
+{
+	size_t next[NHEIGHTS];
+	int c, h;
+
+	l->cells = malloc(((size_t)m->height * (size_t)m->width + 1) *
+	    sizeof(*l->cells));
+	if (l->cells == NULL)
+		return -1;
+
+	memset(l->start, 0, sizeof(l->start));
+	for (c = 0; c < m->height * m->width; ++c) {
+		h = m->heights[c];
+		if (h >= 0 && h < NHEIGHTS)
+			++l->start[h + 1];
+	}
+	for (h = 0; h < NHEIGHTS; ++h) {
+		l->start[h + 1] += l->start[h];
+		next[h] = l->start[h];
+	}
+
+	for (c = 0; c < m->height * m->width; ++c) {
+		h = m->heights[c];
+		if (h >= 0 && h < NHEIGHTS)
+			l->cells[next[h]++] = c;
 	}
+	return 0;
 }
 
-int
-main(void)
+static int
+popcount(unsigned long v)
 {
-	int part1_score = 0;
-	int part2_score = 0;
-	int x, y;
+	int n;
+
+	for (n = 0; v != 0; ++n)
+		v &= v - 1;
+	return n;
+}
 
-	read_input();
+/*
+ * Ratings: the number of trails from a cell is the sum over its neighbours
+ * one step higher, so a single sweep from 9 down to 0 counts them all.
+ */
+static long
+sum_ratings(const struct Map *m, const struct Layers *l, long *paths)
+{
+	long total = 0;
+	size_t i;
+	int h, d, c, x, y, nx, ny;
+
+	for (i = l->start[9]; i < l->start[10]; ++i)
+		paths[l->cells[i]] = 1;
+
+	for (h = 8; h >= 0; --h) {
+		for (i = l->start[h]; i < l->start[h + 1]; ++i) {
+			long sum = 0;
+
+			c = l->cells[i];
+			x = c % m->width;
+			y = c / m->width;
+			for (d = 0; d < 4; ++d) {
+				nx = x + dx[d];
+				ny = y + dy[d];
+				if (nx >= 0 && nx < m->width && ny >= 0 && ny < m->height &&
+				    m->heights[ny * m->width + nx] == h + 1)
+					sum += paths[ny * m->width + nx];
+			}
+			paths[c] = sum;
+		}
+	}
+
+	for (i = l->start[0]; i < l->start[1]; ++i)
+		total += paths[l->cells[i]];
+	return total;
+}
+
+/*
+ * Scores: the same sweep, but each cell carries the set of 9s it can reach.
+ * The 9s are taken MASK_BITS at a time so a set is one word per cell, and
+ * each batch only walks the cells that can reach one of its 9s.
+ */
+static long
+sum_scores(const struct Map *m, const struct Layers *l, unsigned long *reach,
+    unsigned int *stamp, int *frontier, int *next)
+{
+	long total = 0;
+	size_t nines, base, i, n, nnext;
+	unsigned int batch = 0;
+	int h, d, c, x, y, nx, ny, nc;
+	int *tmp;
+
+	nines = l->start[10] - l->start[9];
+	for (base = 0; base < nines; base += MASK_BITS) {
+		++batch;
+		n = 0;
+		for (i = 0; i < MASK_BITS && base + i < nines; ++i) {
+			c = l->cells[l->start[9] + base + i];
+			reach[c] = 1UL << i;
+			frontier[n++] = c;
+		}
 
-	for (y = 0; y < height; ++y) {
-		for (x = 0; x < width; ++x) {
-			if (grid[y][x] == 0) {
-				part1_score += count_reachable_nines(x, y);
-				part2_score += count_trails_from_trailhead(x, y);
+		for (h = 9; h > 0 && n > 0; --h) {
+			nnext = 0;
+			for (i = 0; i < n; ++i) {
+				c = frontier[i];
+				x = c % m->width;
+				y = c / m->width;
+				for (d = 0; d < 4; ++d) {
+					nx = x + dx[d];
+					ny = y + dy[d];
+					if (nx < 0 || nx >= m->width || ny < 0 || ny >= m->height ||
+					    m->heights[ny * m->width + nx] != h - 1)
+						continue;
+
+					nc = ny * m->width + nx;
+					if (stamp[nc] != batch) {
+						stamp[nc] = batch;
+						reach[nc] = 0;
+						next[nnext++] = nc;
+					}
+					reach[nc] |= reach[c];
+				}
 			}
+			tmp = frontier;
+			frontier = next;
+			next = tmp;
+			n = nnext;
+		}
+
+		if (h == 0) {
+			for (i = 0; i < n; ++i)
+				total += popcount(reach[frontier[i]]);
+		}
+	}
+	return total;
+}
+
+static int
+solve_layered(const struct Map *m, struct results *r, long *part1, long *part2)
+{
+	struct Layers layers;
+	size_t cells = (size_t)m->height * (size_t)m->width + 1;
+	unsigned long *reach;
+	unsigned int *stamp;
+	int *frontier, *next;
+	long *paths;
+	struct phase *phase;
+
+	int rc = -1;
+
+	phase = results_phase(r, "part1");
+	if (build_layers(m, &layers) == -1)
+		return -1;
+	reach = malloc(cells * sizeof(*reach));
+	stamp = calloc(cells, sizeof(*stamp));
+	frontier = malloc(cells * sizeof(*frontier));
+	next = malloc(cells * sizeof(*next));
+	paths = malloc(cells * sizeof(*paths));
+	if (reach == NULL || stamp == NULL || frontier == NULL ||
+	    next == NULL || paths == NULL)
+		goto done;
+
+	*part1 = sum_scores(m, &layers, reach, stamp, frontier, next);
+	phase_end(phase);
+
+	phase = results_phase(r, "part2");
+	*part2 = sum_ratings(m, &layers, paths);
+	phase_end(phase);
+	rc = 0;
+
+done:
+	free(paths);
+	free(next);
+	free(frontier);
+	free(stamp);
+	free(reach);
+	free(layers.cells);
+	return rc;
+}
+
+static void
+search_trailheads(void *arg, size_t first, size_t last, int worker,
+    long *acc)
+{
+	struct Work *w = arg;
+	const struct Map *m = w->map;
+	struct Scratch *scratch = &w->scratch[worker];
+	size_t i;
+	int x, y;
+
+	for (i = first; i < last; ++i) {
+		x = w->trailheads[i] % m->width;
+		y = w->trailheads[i] / m->width;
+		acc[0] += count_reachable_nines(m, scratch, x, y);
+		acc[1] += count_trails_from_trailhead(m, scratch, x, y);
+	}
+}
+
+/*
+ * One search per trailhead; kept as a reference for the layered solver.
+ * The trailheads are shared out over the pool, where every worker keeps
+ * its own visited buffer, queue and partial sums.
+ */
+static int
+solve_search(const struct Map *m, struct pool *pool, long *part1,
+    long *part2)
+{
+	struct Work work;
+	int *trailheads;
+	size_t ntrailheads;
+	long sums[2];
+	int c, i, nthreads;
+	int rc = -1;
+
+	trailheads = malloc(((size_t)m->height * (size_t)m->width + 1) *
+	    sizeof(*trailheads));
+	if (trailheads == NULL)
+		return -1;
+
+	ntrailheads = 0;
+	for (c = 0; c < m->height * m->width; ++c) {
+		if (m->heights[c] == 0)
+			trailheads[ntrailheads++] = c;
+	}
+
+	nthreads = pool_threads(pool);
+	work.map = m;
+	work.trailheads = trailheads;
+	if ((work.scratch = calloc((size_t)nthreads,
+	    sizeof(*work.scratch))) == NULL) {
+		free(trailheads);
+		return -1;
+	}
+	/* All scratch is set up here, so the workers cannot run out. */
+	for (i = 0; i < nthreads; ++i)
+		if (init_scratch(&work.scratch[i], (size_t)m->height *
+		    (size_t)m->width) == -1)
+			goto done;
+
+	pool_sum(pool, ntrailheads, TRAILHEAD_GRAIN, search_trailheads, &work,
+	    sums, 2);
+	*part1 = sums[0];
+	*part2 = sums[1];
+	rc = 0;
+
+done:
+	for (i = 0; i < nthreads; ++i)
+		free_scratch(&work.scratch[i]);
+	free(work.scratch);
+	free(trailheads);
+	return rc;
+}
+
+/*
+ * Parse the map and run the layered solver, or given a pool the
+ * per-trailhead searches on its threads.
+ */
+static int
+solve(const struct input *input, struct pool *pool, struct results *r)
+{
+	struct Map map;
+	struct phase *phase;
+	long part1_score, part2_score;
+	FILE *fp;
+	int rc;
+
+	phase = results_phase(r, "parse");
+	if ((fp = input_stream(input)) == NULL)
+		return -1;
+	rc = read_input(fp, &map);
+	fclose(fp);
+	if (rc == -1)
+		return -1;
+	phase_end(phase);
+
+	if (pool != NULL) {
+		/* Both parts come out of the same search. */
+		phase = results_phase(r, "parts");
+		rc = solve_search(&map, pool, &part1_score, &part2_score);
+		phase_end(phase);
+	} else
+		rc = solve_layered(&map, r, &part1_score, &part2_score);
+
+	free(map.heights);
+	if (rc == -1)
+		return -1;
+
+	sprintf(r->part1, "%ld", part1_score);
+	sprintf(r->part2, "%ld", part2_score);
+	return 0;
+}
+
+int
+solve_day10(const struct input *input, struct results *r)
+{
+	return solve(input, NULL, r);
+}
+
+#ifndef AOC_RUNNER
+static void
+usage(void)
+{
+	fprintf(stderr,
+	    "usage: main.exe [-ps] [-j threads] [input.txt | -]\n");
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct input input;
+	struct results results;
+	struct pool *pool = NULL;
+	const char *path;
+	char *end;
+	long n;
+	int search = 0;
+	int nthreads = 1;
+	int pin = 0;
+	int ch;
+
+	while ((ch = getopt(argc, argv, "j:ps")) != -1) {
+		switch (ch) {
+		case 'j':
+			n = strtol(optarg, &end, 10);
+			if (*optarg == '\0' || *end != '\0' ||
+			    n < 1 || n > POOL_MAX_THREADS)
+				errx(1, "threads must be between 1 and %d",
+				    POOL_MAX_THREADS);
+			nthreads = (int)n;
+			search = 1;
+			break;
+		case 'p':
+			pin = 1;
+			search = 1;
+			break;
+		case 's':
+			search = 1;
+			break;
+		default:
+			usage();
 		}
 	}
+	if (argc - optind > 1)
+		usage();
+
+	path = optind < argc ? argv[optind] : "input.txt";
+	if (input_load(&input, path) == -1)
+		err(1, "%s", path);
+
+	if (search && (pool = pool_create(nthreads, pin)) == NULL) {
+		warn("pool_create");
+		input_close(&input);
+		return 1;
+	}
+
+	results_init(&results);
+	if (solve(&input, pool, &results) == -1) {
+		input_close(&input);
+		pool_destroy(pool);
+		errx(1, "failed to parse input");
+	}
+	input_close(&input);
+	pool_destroy(pool);
 
-	printf("part 1 =\n\t%d\n", part1_score);
-	printf("part 2 =\n\t%d\n", part2_score);
+	printf("part 1 =\n\t%s\n", results.part1);
+	printf("part 2 =\n\t%s\n", results.part2);
 	return 0;
 }
+#endif
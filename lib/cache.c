@@ -0,0 +1,216 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cache.h"
+
+#define CACHE_MAGIC	"AOCCACHE"
+#define CACHE_VERSION	2
+#define CACHE_ALIGN	8
+#define MAX_PATH	4096
+
+struct header {
+	char		magic[8];
+	uint32_t	version;	/* also tells the byte order apart */
+	uint32_t	day;
+	uint64_t	source_size;
+	uint64_t	source_hash;
+	uint32_t	nsections;
+	uint32_t	pad;
+	uint64_t	offset[CACHE_MAX_SECTIONS];	/* from the file start */
+	uint64_t	size[CACHE_MAX_SECTIONS];
+};
+
+/* FNV-1a, 64 bits. */
+static uint64_t
+hash_text(const char *data, size_t size)
+{
+	uint64_t h = UINT64_C(0xcbf29ce484222325);
+	size_t i;
+
+	for (i = 0; i < size; ++i) {
+		h ^= (unsigned char)data[i];
+		h *= UINT64_C(0x100000001b3);
+	}
+	return h;
+}
+
+static int
+cache_path(char *buf, const struct input *in)
+{
+	if (in->path == NULL || strlen(in->path) + 5 > MAX_PATH) {
+		errno = ENOENT;
+		return -1;
+	}
+	sprintf(buf, "%s.bin", in->path);
+	return 0;
+}
+
+/*
+ * Whether h describes a cache of day built from the text of in.  The hash
+ * is always checked: a text edited in place can keep its size and get its
+ * old mtime back, so neither shows the cache is still good, and the size
+ * only rules one out early.
+ */
+static int
+fresh(const struct header *h, const struct input *in, int day)
+{
+	if (memcmp(h->magic, CACHE_MAGIC, sizeof(h->magic)) != 0 ||
+	    h->version != CACHE_VERSION || h->day != (uint32_t)day ||
+	    h->nsections > CACHE_MAX_SECTIONS ||
+	    h->source_size != (uint64_t)in->size)
+		return 0;
+	return h->source_hash == hash_text(in->data, in->size);
+}
+
+/*
+ * Map the cache of in for day.  Returns -1, with nothing mapped, when there
+ * is none or it is stale or damaged; the caller then parses the text.
+ */
+int
+cache_open(struct cache *c, const struct input *in, int day)
+{
+	char path[MAX_PATH];
+	const struct header *h;
+	struct stat sb;
+	void *p;
+	uint32_t i;
+	int fd;
+
+	memset(c, 0, sizeof(*c));
+	if (cache_path(path, in) == -1)
+		return -1;
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return -1;
+	if (fstat(fd, &sb) == -1 || sb.st_size < (off_t)sizeof(*h)) {
+		close(fd);
+		return -1;
+	}
+	p = mmap(NULL, (size_t)sb.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	    fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		return -1;
+
+	h = p;
+	if (!fresh(h, in, day))
+		goto stale;
+	for (i = 0; i < h->nsections; ++i) {
+		if (h->offset[i] > (uint64_t)sb.st_size ||
+		    h->size[i] > (uint64_t)sb.st_size - h->offset[i])
+			goto stale;
+		c->section[i] = (char *)p + h->offset[i];
+		c->size[i] = (size_t)h->size[i];
+	}
+	c->nsections = (int)h->nsections;
+	c->map = p;
+	c->mapped = (size_t)sb.st_size;
+	return 0;
+
+stale:
+	munmap(p, (size_t)sb.st_size);
+	memset(c, 0, sizeof(*c));
+	return -1;
+}
+
+static int
+write_all(int fd, const void *buf, size_t size)
+{
+	const char *p = buf;
+	ssize_t n;
+
+	while (size > 0) {
+		if ((n = write(fd, p, size)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		size -= (size_t)n;
+	}
+	return 0;
+}
+
+/*
+ * Write the sections of c as the cache of in for day.  The file is built
+ * under a temporary name and renamed into place, so a reader never maps a
+ * half-written cache.  Returns -1 with errno set on failure.
+ */
+int
+cache_write(const struct cache *c, const struct input *in, int day)
+{
+	static const char zeros[CACHE_ALIGN];
+	char path[MAX_PATH], tmp[MAX_PATH + 8];
+	struct header h;
+	uint64_t offset;
+	int fd, i, error;
+
+	if (cache_path(path, in) == -1)
+		return -1;
+	if (c->nsections < 0 || c->nsections > CACHE_MAX_SECTIONS) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, CACHE_MAGIC, sizeof(h.magic));
+	h.version = CACHE_VERSION;
+	h.day = (uint32_t)day;
+	h.source_size = (uint64_t)in->size;
+	h.source_hash = hash_text(in->data, in->size);
+	h.nsections = (uint32_t)c->nsections;
+	offset = sizeof(h);
+	for (i = 0; i < c->nsections; ++i) {
+		offset = (offset + CACHE_ALIGN - 1) / CACHE_ALIGN * CACHE_ALIGN;
+		h.offset[i] = offset;
+		h.size[i] = (uint64_t)c->size[i];
+		offset += c->size[i];
+	}
+
+	sprintf(tmp, "%s.tmp", path);
+	if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+		return -1;
+	if (write_all(fd, &h, sizeof(h)) == -1)
+		goto fail;
+	offset = sizeof(h);
+	for (i = 0; i < c->nsections; ++i) {
+		if (write_all(fd, zeros, (size_t)(h.offset[i] - offset)) == -1 ||
+		    write_all(fd, c->section[i], c->size[i]) == -1)
+			goto fail;
+		offset = h.offset[i] + h.size[i];
+	}
+	if (close(fd) == -1) {
+		fd = -1;
+		goto fail;
+	}
+	if (rename(tmp, path) == -1) {
+		fd = -1;
+		goto fail;
+	}
+	return 0;
+
+fail:
+	error = errno;
+	if (fd != -1)
+		close(fd);
+	unlink(tmp);
+	errno = error;
+	return -1;
+}
+
+void
+cache_close(struct cache *c)
+{
+	if (c->map != NULL)
+		munmap(c->map, c->mapped);
+	memset(c, 0, sizeof(*c));
+}
@@ -0,0 +1,35 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+
+#include "input.h"
+
+/*
+ * Pre-parsed inputs.  A day that can skip its parser keeps the arrays it
+ * parses into in <input>.bin, next to the text, as up to CACHE_MAX_SECTIONS
+ * raw sections behind a header that records the day and the size and
+ * FNV-1a hash of the text they came from.
+ *
+ * cache_open() maps that file when it is still fresh for the input: the
+ * text has the recorded size and hashes to the recorded hash, which is
+ * checked every time.  The sections are then used in place, straight
+ * from the mapping; it is private and writable, so a day may sort them
+ * without touching the file.  The layout is the machine's own, for a
+ * cache next to the input and never shipped elsewhere.
+ */
+#define CACHE_MAX_SECTIONS	4
+
+struct cache {
+	void	*section[CACHE_MAX_SECTIONS];
+	size_t	 size[CACHE_MAX_SECTIONS];	/* bytes */
+	int	 nsections;
+	void	*map;
+	size_t	 mapped;
+};
+
+int	cache_open(struct cache *, const struct input *, int day);
+int	cache_write(const struct cache *, const struct input *, int day);
+void	cache_close(struct cache *);
+
+#endif /* CACHE_H */
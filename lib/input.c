@@ -0,0 +1,161 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "input.h"
+
+#define READ_CHUNK	65536
+
+/*
+ * Room for the rest of fp and its terminating NUL: exactly that when fp is
+ * a regular file, so it is read without growing the buffer, or a first
+ * chunk to double from when the size cannot be known, as with a pipe.
+ */
+static size_t
+read_size(FILE *fp)
+{
+	struct stat sb;
+	off_t offset;
+
+	if (fstat(fileno(fp), &sb) == -1 || !S_ISREG(sb.st_mode))
+		return READ_CHUNK;
+	if ((offset = lseek(fileno(fp), 0, SEEK_CUR)) == -1 ||
+	    offset > sb.st_size)
+		return READ_CHUNK;
+	return (size_t)(sb.st_size - offset) + 1;
+}
+
+/* Read the rest of fp into the heap.  Returns -1 with errno set on error. */
+int
+input_read(struct input *in, FILE *fp)
+{
+	char *data, *grown;
+	size_t size, cap;
+	int c;
+
+	size = 0;
+	cap = read_size(fp);
+	if ((data = malloc(cap)) == NULL)
+		return -1;
+
+	/*
+	 * A short read is the end of the data.  A full buffer is only grown
+	 * when there is more to come, so a buffer sized from the file is
+	 * never doubled just to find the end.
+	 */
+	for (;;) {
+		size += fread(data + size, 1, cap - 1 - size, fp);
+		if (size < cap - 1 || (c = getc(fp)) == EOF)
+			break;
+		if ((grown = realloc(data, cap * 2)) == NULL) {
+			free(data);
+			return -1;
+		}
+		data = grown;
+		cap *= 2;
+		data[size++] = (char)c;
+	}
+	if (ferror(fp)) {
+		free(data);
+		errno = EIO;
+		return -1;
+	}
+
+	data[size] = '\0';
+	in->data = data;
+	in->size = size;
+	in->mapped = 0;
+	in->path = NULL;
+	return 0;
+}
+
+/*
+ * Load the file at path, which is kept for as long as the input is.  A
+ * mapping ends in the zero fill of its last page, which terminates the
+ * data for free, so files that end exactly on a page boundary are read
+ * instead, as are empty files and anything that is not a regular file.
+ */
+int
+input_open(struct input *in, const char *path)
+{
+	struct stat sb;
+	FILE *fp;
+	void *p;
+	int fd, error;
+
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return -1;
+	if (fstat(fd, &sb) == -1)
+		goto fail;
+
+	if (S_ISREG(sb.st_mode) && sb.st_size > 0 &&
+	    sb.st_size % sysconf(_SC_PAGESIZE) != 0) {
+		p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p != MAP_FAILED) {
+			close(fd);
+			in->data = p;
+			in->size = (size_t)sb.st_size;
+			in->mapped = (size_t)sb.st_size;
+			in->path = path;
+			return 0;
+		}
+	}
+
+	if ((fp = fdopen(fd, "r")) == NULL)
+		goto fail;
+	error = input_read(in, fp) == -1 ? errno : 0;
+	fclose(fp);
+	if (error == 0)
+		in->path = path;
+	errno = error;
+	return error == 0 ? 0 : -1;
+
+fail:
+	error = errno;
+	close(fd);
+	errno = error;
+	return -1;
+}
+
+/*
+ * Load the input named on a day's command line: a path, or "-" for
+ * standard input.  Standard input is read whole, since every day parses
+ * from one contiguous text (and the caches hash it); a redirected file is
+ * read into a buffer of its exact size, and a pipe into one that doubles,
+ * which glibc grows in place with mremap(2) once it is large.
+ */
+int
+input_load(struct input *in, const char *arg)
+{
+	if (strcmp(arg, "-") != 0)
+		return input_open(in, arg);
+	return input_read(in, stdin);
+}
+
+/* A stdio stream over the data, for parsers written against FILE. */
+FILE *
+input_stream(const struct input *in)
+{
+	return fmemopen((void *)in->data, in->size, "r");
+}
+
+void
+input_close(struct input *in)
+{
+	if (in->mapped > 0)
+		munmap((void *)in->data, in->mapped);
+	else
+		free((void *)in->data);
+	in->data = NULL;
+	in->size = 0;
+	in->mapped = 0;
+	in->path = NULL;
+}
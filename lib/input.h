@@ -0,0 +1,26 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * A whole puzzle input in memory, read-only and followed by a NUL byte so
+ * it can be scanned as a string too.  Regular files are mapped rather than
+ * copied whenever the page after the data is guaranteed to be zero-filled;
+ * anything else is read into the heap.
+ */
+struct input {
+	const char	*data;
+	size_t		 size;
+	size_t		 mapped;	/* length of the mapping, 0 if read */
+	const char	*path;		/* file it came from, NULL if streamed */
+};
+
+int	 input_open(struct input *, const char *);
+int	 input_read(struct input *, FILE *);
+int	 input_load(struct input *, const char *);
+FILE	*input_stream(const struct input *);
+void	 input_close(struct input *);
+
+#endif /* INPUT_H */
@@ -0,0 +1,28 @@
+/*
+ * Puzzle input for the Deno days, named the same way as for the C days:
+ *
+ *	deno run --allow-read main.js [input.txt | -]
+ *
+ * A path is read whole; "-" decodes standard input chunk by chunk as it
+ * streams in, so a generated input can be piped straight through.
+ */
+
+export async function readInput(args = Deno.args) {
+  if (args.length > 1) {
+    console.error("usage: main.js [input.txt | -]");
+    Deno.exit(1);
+  }
+
+  const path = args[0] ?? "input.txt";
+  if (path !== "-") {
+    return Deno.readTextFileSync(path);
+  }
+
+  const decoder = new TextDecoder();
+  const chunks = [];
+  for await (const chunk of Deno.stdin.readable) {
+    chunks.push(decoder.decode(chunk, { stream: true }));
+  }
+  chunks.push(decoder.decode());
+  return chunks.join("");
+}
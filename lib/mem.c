@@ -0,0 +1,86 @@
+#define _GNU_SOURCE		/* RUSAGE_THREAD */
+
+#include <sys/resource.h>
+
+#include <stdio.h>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "mem.h"
+
+/* Faults are counted for the calling thread where the system can. */
+#ifdef RUSAGE_THREAD
+#define FAULT_SCOPE	RUSAGE_THREAD
+#else
+#define FAULT_SCOPE	RUSAGE_SELF
+#endif
+
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define HAVE_MALLINFO2
+#endif
+
+void
+mem_start(struct mem_usage *m)
+{
+	struct rusage ru;
+
+	m->peak_rss = m->heap = m->mapped = -1;
+	m->minor_faults = m->major_faults = -1;
+	m->thread_faults = FAULT_SCOPE != RUSAGE_SELF;
+	if (getrusage(FAULT_SCOPE, &ru) == 0) {
+		m->minor_faults = (double)ru.ru_minflt;
+		m->major_faults = (double)ru.ru_majflt;
+	}
+}
+
+void
+mem_stop(struct mem_usage *m)
+{
+	struct rusage ru;
+#ifdef HAVE_MALLINFO2
+	struct mallinfo2 mi;
+#endif
+
+	if (getrusage(FAULT_SCOPE, &ru) == 0 && m->minor_faults >= 0) {
+		m->minor_faults = (double)ru.ru_minflt - m->minor_faults;
+		m->major_faults = (double)ru.ru_majflt - m->major_faults;
+	} else
+		m->minor_faults = m->major_faults = -1;
+
+	/* ru_maxrss is only kept for the process as a whole. */
+	if (getrusage(RUSAGE_SELF, &ru) == 0) {
+#ifdef __APPLE__
+		m->peak_rss = (double)ru.ru_maxrss;
+#else
+		m->peak_rss = (double)ru.ru_maxrss * 1024;	/* in KiB */
+#endif
+	}
+
+#ifdef HAVE_MALLINFO2
+	mi = mallinfo2();
+	m->heap = (double)mi.uordblks + (double)mi.hblkhd;
+	m->mapped = (double)mi.hblkhd;
+#endif
+}
+
+/*
+ * Append the usage to a line of tab-separated key=value fields: the faults
+ * after fault_scope, thread or process, and the fields that cover the
+ * whole process prefixed with process_.
+ */
+void
+mem_print(const struct mem_usage *m, FILE *fp)
+{
+	if (m->minor_faults >= 0)
+		fprintf(fp, "\tfault_scope=%s\tminor_faults=%.0f"
+		    "\tmajor_faults=%.0f", m->thread_faults ? "thread" :
+		    "process", m->minor_faults, m->major_faults);
+	if (m->peak_rss >= 0)
+		fprintf(fp, "\tprocess_peak_rss_bytes=%.0f", m->peak_rss);
+	if (m->heap >= 0)
+		fprintf(fp, "\tprocess_heap_bytes=%.0f"
+		    "\tprocess_mapped_bytes=%.0f", m->heap, m->mapped);
+}
@@ -0,0 +1,29 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stdio.h>
+
+/*
+ * Memory footprint of a stretch of code: the page faults taken while it
+ * ran, and at its end the peak resident set of the process so far and
+ * what malloc holds.  The faults are the calling thread's where the
+ * system counts them per thread; the peak and the heap are always the
+ * whole process's, other threads' work included, and are reported under
+ * names that say so.  Values the system cannot provide are -1 and left
+ * out of the report.
+ */
+struct mem_usage {
+	double	peak_rss;	/* bytes, high-water mark of the process */
+	double	minor_faults;	/* at mem_start(), then those since */
+	double	major_faults;
+	int	thread_faults;	/* faults are the calling thread's only */
+	double	heap;		/* bytes in live malloc allocations, all
+				   threads' arenas together */
+	double	mapped;		/* of which malloc served with mmap(2) */
+};
+
+void	mem_start(struct mem_usage *);
+void	mem_stop(struct mem_usage *);
+void	mem_print(const struct mem_usage *, FILE *);
+
+#endif /* MEM_H */
@@ -0,0 +1,162 @@
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "perf.h"
+
+static const char *const names[PERF_NEVENTS] = {
+	"cycles",
+	"instructions",
+	"branches",
+	"branch_misses",
+	"l1d_misses",
+	"llc_misses",
+};
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const struct {
+	__u32	type;
+	__u64	config;
+} events[PERF_NEVENTS] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+	    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+	    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+};
+
+/*
+ * Open and start the group.  Fails, with errno set, only when the cycle
+ * counter that leads the group cannot be opened.
+ */
+int
+perf_start(struct perf_group *g)
+{
+	struct perf_event_attr attr;
+	int i;
+
+	for (i = 0; i < PERF_NEVENTS; ++i) {
+		g->fd[i] = -1;
+		g->count[i] = -1;
+	}
+
+	for (i = 0; i < PERF_NEVENTS; ++i) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = events[i].type;
+		attr.config = events[i].config;
+		attr.read_format = PERF_FORMAT_GROUP |
+		    PERF_FORMAT_TOTAL_TIME_ENABLED |
+		    PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.disabled = i == PERF_CYCLES;	/* members follow it */
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		g->fd[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1,
+		    i == PERF_CYCLES ? -1 : g->fd[PERF_CYCLES], 0);
+		if (g->fd[PERF_CYCLES] == -1)
+			return -1;
+	}
+
+	ioctl(g->fd[PERF_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(g->fd[PERF_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return 0;
+}
+
+/* Stop the group, read it into g->count and close it. */
+void
+perf_stop(struct perf_group *g)
+{
+	__u64 values[3 + PERF_NEVENTS];	/* nr, enabled, running, counts */
+	double scale;
+	size_t n;
+	int i;
+
+	if (g->fd[PERF_CYCLES] == -1)
+		return;
+
+	ioctl(g->fd[PERF_CYCLES], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	if (read(g->fd[PERF_CYCLES], values, sizeof(values)) > 0 &&
+	    values[2] > 0) {
+		/* The counts come in the order the members joined. */
+		scale = (double)values[1] / (double)values[2];
+		n = 0;
+		for (i = 0; i < PERF_NEVENTS; ++i)
+			if (g->fd[i] != -1 && n < values[0])
+				g->count[i] = (double)values[3 + n++] * scale;
+	}
+
+	for (i = PERF_NEVENTS - 1; i >= 0; --i) {
+		if (g->fd[i] != -1)
+			close(g->fd[i]);
+		g->fd[i] = -1;
+	}
+}
+
+#else /* !__linux__ */
+
+int
+perf_start(struct perf_group *g)
+{
+	int i;
+
+	for (i = 0; i < PERF_NEVENTS; ++i) {
+		g->fd[i] = -1;
+		g->count[i] = -1;
+	}
+	errno = ENOSYS;
+	return -1;
+}
+
+void
+perf_stop(struct perf_group *g)
+{
+	(void)g;
+}
+
+#endif /* __linux__ */
+
+static void
+print_ratio(FILE *fp, const char *name, double num, double den, double per)
+{
+	if (num >= 0 && den > 0)
+		fprintf(fp, "\t%s=%.4f", name, num * per / den);
+}
+
+/*
+ * Append the counts, and the rates derived from them, to a line of
+ * tab-separated key=value fields, after the scope they were counted in.
+ * Counters that were not read are left out, and so is every rate that
+ * needs them.
+ */
+void
+perf_print(const struct perf_group *g, FILE *fp)
+{
+	const double *c = g->count;
+	int i;
+
+	if (c[PERF_CYCLES] >= 0)
+		fputs("\tperf_scope=thread", fp);
+	for (i = 0; i < PERF_NEVENTS; ++i)
+		if (c[i] >= 0)
+			fprintf(fp, "\t%s=%.0f", names[i], c[i]);
+
+	print_ratio(fp, "ipc", c[PERF_INSTRUCTIONS], c[PERF_CYCLES], 1);
+	print_ratio(fp, "branch_miss_rate", c[PERF_BRANCH_MISSES],
+	    c[PERF_BRANCHES], 1);
+	print_ratio(fp, "l1d_mpki", c[PERF_L1D_MISSES], c[PERF_INSTRUCTIONS],
+	    1000);
+	print_ratio(fp, "llc_mpki", c[PERF_LLC_MISSES], c[PERF_INSTRUCTIONS],
+	    1000);
+}
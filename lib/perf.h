@@ -0,0 +1,36 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdio.h>
+
+/*
+ * Hardware counters for a stretch of code, counted in user space as one
+ * perf_event_open(2) group led by the cycle counter.  Counters the CPU or
+ * kernel cannot provide are left out rather than failing the group.
+ *
+ * Only the thread that starts the group is counted: inheritance would
+ * reach no further than threads created while the group is open, and the
+ * pools the days run on are started before that, so the work of other
+ * threads is not in the counts.  perf_print() says so with perf_scope.
+ */
+enum perf_event {
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_BRANCHES,
+	PERF_BRANCH_MISSES,
+	PERF_L1D_MISSES,		/* L1 data cache read misses */
+	PERF_LLC_MISSES,		/* last-level cache misses */
+	PERF_NEVENTS
+};
+
+struct perf_group {
+	int	fd[PERF_NEVENTS];	/* -1 for counters not open */
+	double	count[PERF_NEVENTS];	/* set by perf_stop(), scaled up
+					   if the group was multiplexed */
+};
+
+int	perf_start(struct perf_group *);
+void	perf_stop(struct perf_group *);
+void	perf_print(const struct perf_group *, FILE *);
+
+#endif /* PERF_H */
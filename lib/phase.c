@@ -0,0 +1,88 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "phase.h"
+
+static int
+flag_set(const char *name)
+{
+	const char *value = getenv(name);
+
+	return value != NULL && value[0] != '\0' &&
+	    !(value[0] == '0' && value[1] == '\0');
+}
+
+static pthread_once_t	probe_once = PTHREAD_ONCE_INIT;
+
+/* Say so if the kernel will not give us any counters. */
+static void
+probe_counters(void)
+{
+	struct perf_group g;
+
+	if (perf_start(&g) == -1)
+		fprintf(stderr, "perf_event_open: %s\n", strerror(errno));
+	else
+		perf_stop(&g);
+}
+
+/*
+ * Start the counters, after a probe that warns once when there are none.
+ * Phases begin on every thread of the runner and the server at once, so
+ * the probe is run through pthread_once().
+ */
+static void
+start_counters(struct perf_group *g)
+{
+	pthread_once(&probe_once, probe_counters);
+	perf_start(g);
+}
+
+void
+phase_begin(struct phase *p, const char *name)
+{
+	struct timespec ts;
+
+	p->perf.fd[PERF_CYCLES] = -1;
+	if (flag_set("AOC_PERF"))
+		start_counters(&p->perf);
+	if (flag_set("AOC_MEM"))
+		mem_start(&p->mem);
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	p->name = name;
+	p->sec = (long)ts.tv_sec;
+	p->nsec = ts.tv_nsec;
+	p->ns = 0;
+}
+
+void
+phase_end(struct phase *p)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	p->ns = ((double)ts.tv_sec - (double)p->sec) * 1e9 +
+	    ((double)ts.tv_nsec - (double)p->nsec);
+
+	if (p->perf.fd[PERF_CYCLES] != -1)
+		perf_stop(&p->perf);
+	if (flag_set("AOC_MEM"))
+		mem_stop(&p->mem);
+
+	if (flag_set("AOC_PHASES") || flag_set("AOC_PERF") ||
+	    flag_set("AOC_MEM")) {
+		fprintf(stderr, "phase\tname=%s\ttime_ns=%.0f", p->name, p->ns);
+		if (flag_set("AOC_PERF"))
+			perf_print(&p->perf, stderr);
+		if (flag_set("AOC_MEM"))
+			mem_print(&p->mem, stderr);
+		fputc('\n', stderr);
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef PHASE_H
+#define PHASE_H
+
+#include "mem.h"
+#include "perf.h"
+
+/*
+ * In-program phase timers.  Each day brackets its parse, part 1 and part 2
+ * work with phase_begin()/phase_end(); when AOC_PHASES is set to anything
+ * but "" or "0", phase_end() reports the phase on stderr as one line of
+ * tab-separated key=value fields:
+ *
+ *	phase	name=parse	time_ns=123456
+ *
+ * With AOC_PERF set the same way, each phase also runs under a group of
+ * hardware counters (see perf.h), and its line carries the counts along
+ * with the IPC and miss rates.  They cover the calling thread only, not
+ * the pool threads of a day run with -j:
+ *
+ *	phase	name=parse	time_ns=123456	perf_scope=thread	cycles=...
+ *
+ * With AOC_MEM set, the line carries the phase's memory footprint (see
+ * mem.h): the page faults it took, on its own thread where they can be
+ * told apart, and the peak RSS and live heap of the whole process at its
+ * end, which also count whatever other threads were doing meanwhile.
+ *
+ *	phase	name=parse	time_ns=123456	fault_scope=thread	...
+ *
+ * The elapsed time is also kept in the struct for callers that report it
+ * themselves.
+ */
+struct phase {
+	const char	*name;
+	long		sec;		/* monotonic start time */
+	long		nsec;
+	double		ns;		/* elapsed, set by phase_end() */
+	struct perf_group perf;		/* read when AOC_PERF is set */
+	struct mem_usage mem;		/* read when AOC_MEM is set */
+};
+
+void	phase_begin(struct phase *, const char *);
+void	phase_end(struct phase *);
+
+#endif /* PHASE_H */
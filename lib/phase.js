@@ -0,0 +1,107 @@
+/*
+ * In-program phase timers for the Deno days, reporting in the same format
+ * as phase.c: with AOC_PHASES set to anything but "" or "0", every phase
+ * ends with a line on stderr like
+ *
+ *	phase	name=parse	time_ns=123456
+ *
+ * With AOC_MEM set the same way, the line also carries the footprint
+ * fields of phase.c: the page faults taken during the phase by the main
+ * thread, which runs it, and at its end the peak RSS and live heap of the
+ * process (Deno.memoryUsage()'s heapUsed, with its external memory as
+ * process_mapped_bytes).  The peak and the faults come from /proc and are
+ * left out where it cannot be read.
+ *
+ * Given an array, phase() and phaseAsync() also append { name, ns } to it,
+ * for callers that report the times themselves.
+ *
+ * The environment is only consulted when env access has been granted, so
+ * a plain `deno main.js` never prompts for it; /proc likewise.
+ */
+
+function env(name) {
+  const { state } = Deno.permissions.querySync({ name: "env", variable: name });
+  return state === "granted" ? Deno.env.get(name) : undefined;
+}
+
+function flagSet(name) {
+  const value = env(name);
+  return value !== undefined && value !== "" && value !== "0";
+}
+
+const memEnabled = flagSet("AOC_MEM");
+const enabled = flagSet("AOC_PHASES") || memEnabled;
+
+/* A file under /proc, "self/status" or "thread-self/stat". */
+function readProc(name) {
+  const path = `/proc/${name}`;
+  const { state } = Deno.permissions.querySync({ name: "read", path });
+  if (state !== "granted") return undefined;
+  try {
+    return Deno.readTextFileSync(path);
+  } catch {
+    return undefined;
+  }
+}
+
+/*
+ * Minor and major faults of the calling thread so far, from the fields
+ * after the command name.
+ */
+function faults() {
+  const stat = readProc("thread-self/stat");
+  if (stat === undefined) return undefined;
+  const fields = stat.slice(stat.lastIndexOf(")") + 2).split(" ");
+  return { minor: Number(fields[7]), major: Number(fields[9]) };
+}
+
+function memStart() {
+  return memEnabled ? faults() : undefined;
+}
+
+/* The footprint fields of a phase that started with the given faults. */
+function memFields(start) {
+  if (!memEnabled) return "";
+
+  let fields = "";
+  const end = faults();
+  if (start !== undefined && end !== undefined) {
+    fields += `\tfault_scope=thread\tminor_faults=${end.minor - start.minor}` +
+      `\tmajor_faults=${end.major - start.major}`;
+  }
+  const peak = readProc("self/status")?.match(/^VmHWM:\s*(\d+) kB/m);
+  if (peak) {
+    fields += `\tprocess_peak_rss_bytes=${Number(peak[1]) * 1024}`;
+  }
+  const { heapUsed, external } = Deno.memoryUsage();
+  return fields +
+    `\tprocess_heap_bytes=${heapUsed}\tprocess_mapped_bytes=${external}`;
+}
+
+/* Run fn as the named phase and return its result. */
+export function phase(name, fn, times) {
+  const faults = memStart();
+  const start = performance.now();
+  const result = fn();
+  const ns = Math.round((performance.now() - start) * 1e6);
+
+  times?.push({ name, ns });
+  if (enabled) {
+    console.error(`phase\tname=${name}\ttime_ns=${ns}${memFields(faults)}`);
+  }
+  return result;
+}
+
+/* phase() for work that finishes asynchronously. */
+export async function phaseAsync(name, fn, times) {
+  const faults = memStart();
+  const start = performance.now();
+  const result = await fn();
+  const ns = Math.round((performance.now() - start) * 1e6);
+
+  times?.push({ name, ns });
+  if (enabled) {
+    console.error(`phase\tname=${name}\ttime_ns=${ns}${memFields(faults)}`);
+  }
+  return result;
+}
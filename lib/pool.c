@@ -0,0 +1,329 @@
+#define _GNU_SOURCE		/* pthread_attr_setaffinity_np(), CPU_SET() */
+
+#include <err.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+#define CACHE_LINE	64
+
+/* Fraction of its remaining range a worker takes off the front at once. */
+#define CHUNK_SPLIT	8
+
+/*
+ * A worker's deque of indexes, [begin, end), and its accumulators.  The
+ * deque is written by thieves as well, so the accumulators, which only
+ * the owner writes, are padded off onto lines of their own.
+ */
+struct worker {
+	pthread_mutex_t	 lock;
+	size_t		 begin;
+	size_t		 end;
+	char		 pad0[CACHE_LINE];	/* keeps acc off the deque */
+	long		 acc[POOL_MAX_SUMS];
+	pthread_t	 thread;
+	struct pool	*pool;
+	int		 id;
+	char		 pad1[CACHE_LINE];	/* keeps neighbours apart */
+};
+
+struct pool {
+	struct worker	*workers;
+	int		 nthreads;
+	int		 nstarted;	/* threads running, worker 0 excluded */
+
+	pthread_mutex_t	 lock;		/* guards the fields below */
+	pthread_cond_t	 start;
+	pthread_cond_t	 done;
+	unsigned long	 generation;	/* bumped for every loop */
+	int		 busy;		/* workers still in the loop */
+	int		 quit;
+
+	/* The current loop, read by the workers once it has been posted. */
+	pool_fn		*fn;
+	pool_sum_fn	*sum_fn;
+	void		*ctx;
+	size_t		 grain;
+};
+
+static void
+lock(pthread_mutex_t *m)
+{
+	int error;
+
+	if ((error = pthread_mutex_lock(m)) != 0)
+		errx(1, "pthread_mutex_lock: %s", strerror(error));
+}
+
+static void
+unlock(pthread_mutex_t *m)
+{
+	int error;
+
+	if ((error = pthread_mutex_unlock(m)) != 0)
+		errx(1, "pthread_mutex_unlock: %s", strerror(error));
+}
+
+/* Take the next chunk off the front of w's own range. */
+static int
+take(struct worker *w, size_t grain, size_t *begin, size_t *end)
+{
+	size_t left, chunk;
+
+	lock(&w->lock);
+	left = w->end - w->begin;
+	chunk = left / CHUNK_SPLIT;
+	if (chunk < grain)
+		chunk = grain;
+	if (chunk > left)
+		chunk = left;
+	*begin = w->begin;
+	*end = w->begin + chunk;
+	w->begin += chunk;
+	unlock(&w->lock);
+
+	return chunk > 0;
+}
+
+/*
+ * Move the back half of the first other worker's range that has any left
+ * into w's own, which is empty.  Returns 0 when there was nothing to take.
+ */
+static int
+steal(struct pool *p, struct worker *w)
+{
+	struct worker *victim;
+	size_t begin, end, half;
+	int i;
+
+	for (i = 1; i < p->nthreads; ++i) {
+		victim = &p->workers[(w->id + i) % p->nthreads];
+
+		lock(&victim->lock);
+		half = victim->end - victim->begin;
+		half -= half / 2;
+		end = victim->end;
+		begin = victim->end - half;
+		victim->end = begin;
+		unlock(&victim->lock);
+
+		if (half > 0) {
+			lock(&w->lock);
+			w->begin = begin;
+			w->end = end;
+			unlock(&w->lock);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void
+run_loop(struct pool *p, struct worker *w)
+{
+	size_t begin, end;
+
+	memset(w->acc, 0, sizeof(w->acc));
+	do {
+		while (take(w, p->grain, &begin, &end)) {
+			if (p->sum_fn != NULL)
+				p->sum_fn(p->ctx, begin, end, w->id, w->acc);
+			else
+				p->fn(p->ctx, begin, end, w->id);
+		}
+	} while (steal(p, w));
+
+	lock(&p->lock);
+	if (--p->busy == 0)
+		pthread_cond_signal(&p->done);
+	unlock(&p->lock);
+}
+
+static void *
+thread_main(void *arg)
+{
+	struct worker *w = arg;
+	struct pool *p = w->pool;
+	unsigned long seen = 0;
+
+	for (;;) {
+		lock(&p->lock);
+		while (p->generation == seen && !p->quit)
+			pthread_cond_wait(&p->start, &p->lock);
+		seen = p->generation;
+		if (p->quit) {
+			unlock(&p->lock);
+			return NULL;
+		}
+		unlock(&p->lock);
+
+		run_loop(p, w);
+	}
+}
+
+/* Bind the thread about to be started for worker id to one allowed CPU. */
+static void
+pin_attr(pthread_attr_t *attr, int id)
+{
+#ifdef __linux__
+	cpu_set_t allowed, cpu;
+	int c, n, ncpus;
+
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == -1)
+		return;
+	if ((ncpus = CPU_COUNT(&allowed)) == 0)
+		return;
+
+	n = id % ncpus;
+	for (c = 0; c < CPU_SETSIZE; ++c) {
+		if (CPU_ISSET(c, &allowed) && n-- == 0)
+			break;
+	}
+	CPU_ZERO(&cpu);
+	CPU_SET(c, &cpu);
+	pthread_attr_setaffinity_np(attr, sizeof(cpu), &cpu);
+#else
+	(void)attr;
+	(void)id;
+#endif
+}
+
+/* Returns NULL with errno set when the pool cannot be set up. */
+struct pool *
+pool_create(int nthreads, int pin)
+{
+	pthread_attr_t attr;
+	struct pool *p;
+	int i, error;
+
+	if (nthreads < 1 || nthreads > POOL_MAX_THREADS) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((p = calloc(1, sizeof(*p))) == NULL)
+		return NULL;
+	if ((p->workers = calloc((size_t)nthreads, sizeof(*p->workers))) ==
+	    NULL) {
+		free(p);
+		return NULL;
+	}
+
+	p->nthreads = nthreads;
+	pthread_mutex_init(&p->lock, NULL);
+	pthread_cond_init(&p->start, NULL);
+	pthread_cond_init(&p->done, NULL);
+	for (i = 0; i < nthreads; ++i) {
+		p->workers[i].pool = p;
+		p->workers[i].id = i;
+		pthread_mutex_init(&p->workers[i].lock, NULL);
+	}
+
+	for (i = 1; i < nthreads; ++i) {
+		pthread_attr_init(&attr);
+		if (pin)
+			pin_attr(&attr, i);
+		error = pthread_create(&p->workers[i].thread, &attr,
+		    thread_main, &p->workers[i]);
+		pthread_attr_destroy(&attr);
+		if (error != 0) {
+			pool_destroy(p);
+			errno = error;
+			return NULL;
+		}
+		++p->nstarted;
+	}
+	return p;
+}
+
+void
+pool_destroy(struct pool *p)
+{
+	int i;
+
+	if (p == NULL)
+		return;
+
+	lock(&p->lock);
+	p->quit = 1;
+	pthread_cond_broadcast(&p->start);
+	unlock(&p->lock);
+	for (i = 1; i <= p->nstarted; ++i)
+		pthread_join(p->workers[i].thread, NULL);
+
+	for (i = 0; i < p->nthreads; ++i)
+		pthread_mutex_destroy(&p->workers[i].lock);
+	pthread_cond_destroy(&p->done);
+	pthread_cond_destroy(&p->start);
+	pthread_mutex_destroy(&p->lock);
+	free(p->workers);
+	free(p);
+}
+
+int
+pool_threads(const struct pool *p)
+{
+	return p->nthreads;
+}
+
+static void
+post(struct pool *p, size_t n, size_t grain, pool_fn *fn, pool_sum_fn *sum_fn,
+    void *ctx, int nsums)
+{
+	struct worker *w;
+	int i;
+
+	if (nsums < 0 || nsums > POOL_MAX_SUMS)
+		errx(1, "pool: %d sums, at most %d", nsums, POOL_MAX_SUMS);
+
+	for (i = 0; i < p->nthreads; ++i) {
+		w = &p->workers[i];
+		lock(&w->lock);
+		w->begin = n / (size_t)p->nthreads * (size_t)i;
+		w->end = i == p->nthreads - 1 ? n :
+		    n / (size_t)p->nthreads * (size_t)(i + 1);
+		unlock(&w->lock);
+	}
+
+	lock(&p->lock);
+	p->fn = fn;
+	p->sum_fn = sum_fn;
+	p->ctx = ctx;
+	p->grain = grain > 0 ? grain : 1;
+	p->busy = p->nthreads;
+	++p->generation;
+	pthread_cond_broadcast(&p->start);
+	unlock(&p->lock);
+
+	run_loop(p, &p->workers[0]);
+
+	lock(&p->lock);
+	while (p->busy > 0)
+		pthread_cond_wait(&p->done, &p->lock);
+	unlock(&p->lock);
+}
+
+void
+pool_for(struct pool *p, size_t n, size_t grain, pool_fn *fn, void *ctx)
+{
+	post(p, n, grain, fn, NULL, ctx, 0);
+}
+
+void
+pool_sum(struct pool *p, size_t n, size_t grain, pool_sum_fn *fn, void *ctx,
+    long *sums, int nsums)
+{
+	int i, j;
+
+	post(p, n, grain, NULL, fn, ctx, nsums);
+
+	for (j = 0; j < nsums; ++j)
+		sums[j] = 0;
+	for (i = 0; i < p->nthreads; ++i) {
+		for (j = 0; j < nsums; ++j)
+			sums[j] += p->workers[i].acc[j];
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/*
+ * A fixed set of threads for data-parallel loops over index ranges.
+ *
+ * pool_for() deals [0, n) out as one contiguous range per worker.  A
+ * worker takes chunks off the front of its own range, a fraction of what
+ * is left each time so the chunks shrink as the range drains, never below
+ * the grain; once its range is empty it steals the back half of another
+ * worker's.  The calling thread is worker 0 and the call returns when
+ * every index has been run.
+ *
+ * pool_sum() does the same with per-thread reductions: each worker adds
+ * into its own zeroed array of nsums accumulators, on cache lines of its
+ * own, and the arrays are added into sums once the loop is over.
+ *
+ * The body is told which worker runs it, so per-worker scratch space can
+ * be kept in an array indexed by it.  With pin set, the threads the pool
+ * starts are each bound to one of the CPUs the process may run on; the
+ * calling thread keeps its own affinity.
+ */
+#define POOL_MAX_THREADS	256
+#define POOL_MAX_SUMS		8
+
+struct pool;
+
+typedef void	pool_fn(void *ctx, size_t begin, size_t end, int worker);
+typedef void	pool_sum_fn(void *ctx, size_t begin, size_t end, int worker,
+		    long *acc);
+
+struct pool	*pool_create(int nthreads, int pin);
+void		 pool_destroy(struct pool *);
+int		 pool_threads(const struct pool *);
+void		 pool_for(struct pool *, size_t n, size_t grain, pool_fn *,
+		    void *ctx);
+void		 pool_sum(struct pool *, size_t n, size_t grain, pool_sum_fn *,
+		    void *ctx, long *sums, int nsums);
+
+#endif /* POOL_H */
@@ -0,0 +1,58 @@
+# Build profiles shared by the C days, chosen per invocation:
+#
+#	make compile			as before: no optimisation flags
+#	make compile PROFILE=release	-O2 with link-time optimisation
+#	make compile PROFILE=native	release tuned for the host CPU
+#	make compile PROFILE=pgo	release, rebuilt with a profile taken
+#					from a training run on $(TRAIN)
+#
+# The including Makefile sets SRCS and adds $(PROFILE_CFLAGS) to its
+# compile line, $(PGO_BUILD) to the start of the compile recipe and
+# $(PGO_FILES) to what clean removes.  The training input comes from the
+# generator (make gen at the top level).
+#
+# The profile is made by a make of its own once clean has run: as a
+# prerequisite of compile it would run alongside clean under make -j, or
+# be found up to date just before clean removed it.
+
+PROFILE =
+LTO = -flto
+OPT = -O2 $(LTO)
+DAY = $(notdir $(CURDIR))
+TRAIN = ../gen/$(DAY)/random-10/input.txt
+
+PGO_DIR = $(CURDIR)/pgo.d
+PGO_FILES = pgo.d pgo.profdata
+
+ifneq ($(filter-out release native pgo,$(PROFILE)),)
+$(error unknown PROFILE '$(PROFILE)': use release, native or pgo)
+endif
+
+PROFILE_CFLAGS_release = $(OPT)
+PROFILE_CFLAGS_native = $(OPT) -march=native
+
+# clang writes raw profiles that llvm-profdata has to merge; gcc reads its
+# own .gcda files straight from the profile directory.
+ifneq ($(shell $(CC) --version 2>/dev/null | grep -c clang),0)
+PROFILE_CFLAGS_pgo = $(OPT) -fprofile-use=$(CURDIR)/pgo.profdata
+PGO_DATA_pgo = pgo.profdata
+else
+PROFILE_CFLAGS_pgo = $(OPT) -fprofile-use=$(PGO_DIR)
+PGO_DATA_pgo = pgo.d
+endif
+
+PROFILE_CFLAGS = $(PROFILE_CFLAGS_$(PROFILE))
+PGO_DATA = $(PGO_DATA_$(PROFILE))
+PGO_BUILD = $(if $(PGO_DATA),$(MAKE) -s $(PGO_DATA),:)
+
+pgo.d: $(TRAIN)
+	@rm -rf pgo.d
+	@$(CC) $(CPPFLAGS) $(CFLAGS) $(OPT) -fprofile-generate=$(PGO_DIR) \
+	    -o main.exe $(SRCS) $(LDFLAGS)
+	@./main.exe $(TRAIN) > /dev/null
+
+pgo.profdata: pgo.d
+	@llvm-profdata merge -o $@ pgo.d
+
+$(TRAIN):
+	$(error no training input $(TRAIN): run 'make gen' at the top level)
@@ -0,0 +1,23 @@
+#include <string.h>
+
+#include "solve.h"
+
+void
+results_init(struct results *r)
+{
+	memset(r, 0, sizeof(*r));
+}
+
+/*
+ * Begin the next phase of a solver.  Should a solver ever run more phases
+ * than there is room for, the last slot is reused.
+ */
+struct phase *
+results_phase(struct results *r, const char *name)
+{
+	struct phase *p;
+
+	p = &r->phases[r->nphases < MAX_PHASES ? r->nphases++ : MAX_PHASES - 1];
+	phase_begin(p, name);
+	return p;
+}
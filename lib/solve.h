@@ -0,0 +1,35 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include "input.h"
+#include "phase.h"
+
+/*
+ * Entry points of the C days, shared by each day's own main() and by the
+ * runner.  A solver takes the whole input from memory and fills in both
+ * answers, formatted as the day prints them, along with the timing of
+ * every phase it ran.  It returns -1 when the input cannot be parsed or
+ * memory runs out, having freed what it allocated; it never exits, so a
+ * bad input cannot take the runner or the server down with it.
+ */
+#define RESULT_SIZE	32
+#define MAX_PHASES	4
+
+struct results {
+	char		part1[RESULT_SIZE];
+	char		part2[RESULT_SIZE];
+	struct phase	phases[MAX_PHASES];
+	int		nphases;
+};
+
+void		 results_init(struct results *);
+struct phase	*results_phase(struct results *, const char *);
+
+int	solve_day01(const struct input *, struct results *);
+int	solve_day02(const struct input *, struct results *);
+int	solve_day03(const struct input *, struct results *);
+int	solve_day04(const struct input *, struct results *);
+int	solve_day05(const struct input *, struct results *);
+int	solve_day10(const struct input *, struct results *);
+
+#endif /* SOLVE_H */
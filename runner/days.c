@@ -0,0 +1,27 @@
+#include <string.h>
+
+#include "days.h"
+
+const struct day days[] = {
+	{ "01", solve_day01 },
+	{ "02", solve_day02 },
+	{ "03", solve_day03 },
+	{ "04", solve_day04 },
+	{ "05", solve_day05 },
+	{ "10", solve_day10 },
+};
+
+const size_t ndays = sizeof(days) / sizeof(days[0]);
+
+/* The day named by the len bytes at name, or NULL. */
+const struct day *
+find_day(const char *name, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < ndays; ++i)
+		if (strlen(days[i].name) == len &&
+		    strncmp(days[i].name, name, len) == 0)
+			return &days[i];
+	return NULL;
+}
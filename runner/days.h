@@ -0,0 +1,19 @@
+#ifndef DAYS_H
+#define DAYS_H
+
+#include <stddef.h>
+
+#include "solve.h"
+
+/* The C days linked into the runner and the server, by name. */
+struct day {
+	const char	*name;
+	int		(*solve)(const struct input *, struct results *);
+};
+
+extern const struct day	days[];
+extern const size_t	ndays;
+
+const struct day	*find_day(const char *, size_t);
+
+#endif /* DAYS_H */
@@ -0,0 +1,193 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "days.h"
+#include "pool.h"
+
+#define MAX_PATH	4096
+
+/* A selected day with its input, loaded once for every run. */
+struct job {
+	const struct day	*day;
+	char			 path[MAX_PATH];
+	struct input		 input;
+	struct results		 results;	/* of the latest run */
+	double			 best[MAX_PHASES];	/* fastest run, per phase */
+	double			 best_total;
+	int			 failed;
+};
+
+static void
+run_job(struct job *job)
+{
+	struct phase total;
+	int i, rc;
+
+	results_init(&job->results);
+	phase_begin(&total, job->day->name);
+	rc = job->day->solve(&job->input, &job->results);
+	phase_end(&total);
+	if (rc == -1) {
+		job->failed = 1;
+		return;
+	}
+
+	for (i = 0; i < job->results.nphases; ++i)
+		if (job->best[i] == 0 || job->results.phases[i].ns < job->best[i])
+			job->best[i] = job->results.phases[i].ns;
+	if (job->best_total == 0 || total.ns < job->best_total)
+		job->best_total = total.ns;
+}
+
+static void
+run_jobs(void *arg, size_t first, size_t last, int worker)
+{
+	struct job *jobs = arg;
+	size_t i;
+
+	(void)worker;
+	for (i = first; i < last; ++i)
+		run_job(&jobs[i]);
+}
+
+/* Select the day named by arg, "NN" or "NN=path", where "-" is stdin. */
+static void
+add_job(struct job *job, const char *arg, const char *root)
+{
+	const char *eq;
+	size_t len;
+
+	memset(job, 0, sizeof(*job));
+	eq = strchr(arg, '=');
+	len = eq != NULL ? (size_t)(eq - arg) : strlen(arg);
+	if ((job->day = find_day(arg, len)) == NULL)
+		errx(1, "no such day: %.*s", (int)len, arg);
+
+	if (eq != NULL)
+		len = strlen(eq + 1) < MAX_PATH ? (size_t)sprintf(job->path,
+		    "%s", eq + 1) : MAX_PATH;
+	else if (strlen(root) + 16 < MAX_PATH)
+		len = (size_t)sprintf(job->path, "%s/%s/input.txt", root,
+		    job->day->name);
+	else
+		len = MAX_PATH;
+	if (len >= MAX_PATH)
+		errx(1, "path too long for day %s", job->day->name);
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: runner.exe [-p] [-j threads] [-n runs] "
+	    "[-r root] [day[=input]] ...\n");
+	exit(1);
+}
+
+static int
+parse_count(const char *arg, int max, const char *what)
+{
+	char *end;
+	long n;
+
+	n = strtol(arg, &end, 10);
+	if (*arg == '\0' || *end != '\0' || n < 1 || n > max)
+		errx(1, "%s must be between 1 and %d", what, max);
+	return (int)n;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct job *jobs;
+	struct pool *pool;
+	struct phase suite;
+	const char *root = "..";
+	double best_suite = 0;
+	size_t njobs, j;
+	long ncpus;
+	int nthreads = 0, nruns = 1, nstdin = 0, pin = 0, failed = 0;
+	int ch, i, run;
+
+	while ((ch = getopt(argc, argv, "j:n:pr:")) != -1) {
+		switch (ch) {
+		case 'j':
+			nthreads = parse_count(optarg, POOL_MAX_THREADS,
+			    "threads");
+			break;
+		case 'p':
+			pin = 1;
+			break;
+		case 'n':
+			nruns = parse_count(optarg, 1000000, "runs");
+			break;
+		case 'r':
+			root = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	njobs = argc > 0 ? (size_t)argc : ndays;
+	if ((jobs = calloc(njobs, sizeof(*jobs))) == NULL)
+		err(1, "calloc");
+	for (j = 0; j < njobs; ++j) {
+		add_job(&jobs[j], argc > 0 ? argv[j] : days[j].name, root);
+		if (strcmp(jobs[j].path, "-") == 0 && nstdin++ > 0)
+			errx(1, "only one day can read stdin");
+	}
+
+	/* Every input is loaded once, up front, and shared by all runs. */
+	for (j = 0; j < njobs; ++j)
+		if (input_load(&jobs[j].input, jobs[j].path) == -1)
+			err(1, "%s", jobs[j].path);
+
+	if (nthreads == 0) {
+		ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = ncpus < 1 ? 1 : ncpus > POOL_MAX_THREADS ?
+		    POOL_MAX_THREADS : (int)ncpus;
+	}
+	if ((size_t)nthreads > njobs)
+		nthreads = (int)njobs;
+	if ((pool = pool_create(nthreads, pin)) == NULL)
+		err(1, "pool_create");
+
+	/* Days are claimed one at a time: each is a sizeable unit of work. */
+	for (run = 0; run < nruns; ++run) {
+		phase_begin(&suite, "suite");
+		pool_for(pool, njobs, 1, run_jobs, jobs);
+		phase_end(&suite);
+		if (best_suite == 0 || suite.ns < best_suite)
+			best_suite = suite.ns;
+	}
+	pool_destroy(pool);
+
+	/* Answers of the last run; times in ms, the fastest of all runs. */
+	for (j = 0; j < njobs; ++j) {
+		input_close(&jobs[j].input);
+		if (jobs[j].failed) {
+			fprintf(stderr, "day %s: cannot parse %s\n",
+			    jobs[j].day->name, jobs[j].path);
+			failed = 1;
+			continue;
+		}
+		printf("%s\tpart1=%s\tpart2=%s", jobs[j].day->name,
+		    jobs[j].results.part1, jobs[j].results.part2);
+		for (i = 0; i < jobs[j].results.nphases; ++i)
+			printf("\t%s=%.3f", jobs[j].results.phases[i].name,
+			    jobs[j].best[i] / 1e6);
+		printf("\ttotal=%.3f\n", jobs[j].best_total / 1e6);
+	}
+	printf("suite\tdays=%lu\tthreads=%d\truns=%d\twall=%.3f\n",
+	    (unsigned long)njobs, nthreads, nruns, best_suite / 1e6);
+
+	free(jobs);
+	return failed;
+}
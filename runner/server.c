@@ -0,0 +1,420 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <err.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "days.h"
+#include "pool.h"
+
+/*
+ * Resident solver: the C days stay loaded and answer requests on a Unix
+ * domain socket, so callers pay neither process startup nor cold page
+ * faults per input.  A connection carries any number of requests, one
+ * after the other, each a line naming the day and where its input is:
+ *
+ *	<day> path <file>\n			input read by the server
+ *	<day> data <size>\n<size bytes>		input sent inline
+ *
+ * and each answered with one line of tab-separated fields, as the runner
+ * prints them, times in ms:
+ *
+ *	ok	part1=...	part2=...	parse=0.123	...	total=1.234
+ *	error	<message>
+ *
+ * Connections are served concurrently, one per pool worker, so there are
+ * at most as many clients at a time as workers (-j); the others wait to
+ * be accepted.  A client that sends nothing for IDLE_TIMEOUT seconds is
+ * dropped, so idle ones cannot hold every worker.  With -d,
+ * requests for days that have no C solver, the Deno days, are passed on
+ * to tools/serve.js listening on the socket given, which keeps those days
+ * loaded and warmed up the same way, and its answer is passed back.
+ */
+
+#define MAX_LINE	(4096 + 32)
+#define MAX_PAYLOAD	((size_t)1 << 30)
+#define IDLE_TIMEOUT	30		/* seconds */
+
+struct server {
+	int		 fd;		/* listening socket */
+	const char	*deno;		/* socket of the Deno days, or NULL */
+};
+
+static void
+reply_error(FILE *out, const char *msg, const char *arg)
+{
+	fprintf(out, "error\t%s%s%s\n", msg, arg != NULL ? ": " : "",
+	    arg != NULL ? arg : "");
+}
+
+static void
+reply_results(FILE *out, const struct results *r, double total_ns)
+{
+	int i;
+
+	fprintf(out, "ok\tpart1=%s\tpart2=%s", r->part1, r->part2);
+	for (i = 0; i < r->nphases; ++i)
+		fprintf(out, "\t%s=%.3f", r->phases[i].name,
+		    r->phases[i].ns / 1e6);
+	fprintf(out, "\ttotal=%.3f\n", total_ns / 1e6);
+}
+
+/* Read size bytes of inline input.  Returns -1 if the peer went away. */
+static int
+read_payload(FILE *in, size_t size, struct input *input)
+{
+	char *data;
+
+	if ((data = malloc(size + 1)) == NULL)
+		return -1;
+	if (fread(data, 1, size, in) != size) {
+		free(data);
+		return -1;
+	}
+	data[size] = '\0';
+	input->data = data;
+	input->size = size;
+	input->mapped = 0;
+	input->path = NULL;
+	return 0;
+}
+
+static int
+connect_to(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	strcpy(addr.sun_path, path);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		return -1;
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static int
+write_all(int fd, const char *p, size_t n)
+{
+	ssize_t w;
+
+	while (n > 0) {
+		if ((w = write(fd, p, n)) == -1) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += w;
+		n -= (size_t)w;
+	}
+	return 0;
+}
+
+/*
+ * Pass a request, with its inline input if there is one, on to the Deno
+ * days' server and its answer back.
+ */
+static void
+forward(const char *deno, const char *line, const struct input *input,
+    FILE *out)
+{
+	char reply[MAX_LINE];
+	FILE *fp;
+	int fd;
+
+	if ((fd = connect_to(deno)) == -1) {
+		reply_error(out, "Deno server unavailable", strerror(errno));
+		return;
+	}
+	if (write_all(fd, line, strlen(line)) == -1 ||
+	    write_all(fd, "\n", 1) == -1 || (input != NULL &&
+	    write_all(fd, input->data, input->size) == -1)) {
+		reply_error(out, "Deno server unavailable", strerror(errno));
+		close(fd);
+		return;
+	}
+
+	if ((fp = fdopen(fd, "r")) == NULL) {
+		reply_error(out, "fdopen", strerror(errno));
+		close(fd);
+		return;
+	}
+	if (fgets(reply, sizeof(reply), fp) != NULL &&
+	    strchr(reply, '\n') != NULL)
+		fputs(reply, out);
+	else
+		reply_error(out, "no answer from the Deno server", NULL);
+	fclose(fp);
+}
+
+/* Answer a request for a day with no C solver. */
+static void
+no_solver(const struct server *s, const char *name, const char *line,
+    const struct input *input, FILE *out)
+{
+	if (s->deno != NULL)
+		forward(s->deno, line, input, out);
+	else
+		reply_error(out, "no such day", name);
+}
+
+/*
+ * Answer one request line.  Returns -1 when the connection cannot go on,
+ * after a short inline payload or an unparsable size.  An inline payload
+ * is always read in full first, whatever the answer, so that it can never
+ * be taken for the next request.
+ */
+static int
+handle(const struct server *s, const char *line, FILE *in, FILE *out)
+{
+	const struct day *day;
+	struct input input;
+	struct results results;
+	struct phase total;
+	char name[8], kind[8], *end;
+	const char *arg;
+	unsigned long size;
+	int n;
+
+	if (sscanf(line, "%7s %7s %n", name, kind, &n) != 2) {
+		reply_error(out, "bad request", NULL);
+		return 0;
+	}
+	arg = line + n;
+	day = find_day(name, strlen(name));
+
+	if (strcmp(kind, "path") == 0) {
+		if (*arg == '\0' || strcmp(arg, "-") == 0) {
+			reply_error(out, "bad path", arg);
+			return 0;
+		}
+		if (day == NULL) {
+			no_solver(s, name, line, NULL, out);
+			return 0;
+		}
+		if (input_load(&input, arg) == -1) {
+			reply_error(out, strerror(errno), arg);
+			return 0;
+		}
+	} else if (strcmp(kind, "data") == 0) {
+		errno = 0;
+		size = strtoul(arg, &end, 10);
+		if (*arg == '\0' || *end != '\0' || errno != 0 ||
+		    size > MAX_PAYLOAD) {
+			reply_error(out, "bad size", arg);
+			return -1;
+		}
+		if (read_payload(in, (size_t)size, &input) == -1)
+			return -1;
+		if (day == NULL) {
+			no_solver(s, name, line, &input, out);
+			input_close(&input);
+			return 0;
+		}
+	} else {
+		reply_error(out, "bad request", kind);
+		return 0;
+	}
+
+	results_init(&results);
+	phase_begin(&total, day->name);
+	n = day->solve(&input, &results);
+	phase_end(&total);
+	input_close(&input);
+
+	if (n == -1)
+		reply_error(out, "cannot parse input for day", day->name);
+	else
+		reply_results(out, &results, total.ns);
+	return 0;
+}
+
+static void
+serve_connection(const struct server *s, int fd)
+{
+	char line[MAX_LINE];
+	FILE *in, *out;
+	size_t len;
+	int wfd;
+
+	if ((wfd = dup(fd)) == -1) {
+		warn("dup");
+		close(fd);
+		return;
+	}
+	if ((in = fdopen(fd, "r")) == NULL || (out = fdopen(wfd, "w")) == NULL) {
+		warn("fdopen");
+		if (in != NULL)
+			fclose(in);
+		else
+			close(fd);
+		close(wfd);
+		return;
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL) {
+		len = strlen(line);
+		if (len == 0 || line[len - 1] != '\n') {
+			reply_error(out, "request line too long", NULL);
+			break;
+		}
+		line[len - 1] = '\0';
+		if (handle(s, line, in, out) == -1)
+			break;
+		if (fflush(out) == EOF)
+			break;
+	}
+
+	fclose(out);
+	fclose(in);
+}
+
+/*
+ * Accept and serve connections for as long as the server runs.  Only a
+ * listening socket that is no longer usable stops it; running out of
+ * descriptors or memory is waited out, as another worker finishing its
+ * connection may be all it takes.
+ */
+static void
+accept_loop(void *arg, size_t first, size_t last, int worker)
+{
+	static const struct timespec backoff = { 0, 100 * 1000 * 1000 };
+	static const struct timeval idle = { IDLE_TIMEOUT, 0 };
+	struct server *s = arg;
+	int fd;
+
+	(void)first;
+	(void)last;
+	(void)worker;
+	for (;;) {
+		if ((fd = accept(s->fd, NULL, NULL)) == -1) {
+			switch (errno) {
+			case EINTR:
+			case ECONNABORTED:
+				continue;
+			case EBADF:
+			case EFAULT:
+			case EINVAL:
+			case ENOTSOCK:
+			case EOPNOTSUPP:
+				err(1, "accept");
+			default:
+				warn("accept");
+				nanosleep(&backoff, NULL);
+				continue;
+			}
+		}
+		if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle,
+		    sizeof(idle)) == -1)
+			warn("setsockopt");
+		serve_connection(s, fd);
+	}
+}
+
+static int
+listen_on(const char *path)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path))
+		errx(1, "socket path too long: %s", path);
+	strcpy(addr.sun_path, path);
+
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1)
+		err(1, "socket");
+	if (unlink(path) == -1 && errno != ENOENT)
+		err(1, "%s", path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1)
+		err(1, "%s", path);
+	if (listen(fd, SOMAXCONN) == -1)
+		err(1, "listen");
+	return fd;
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr,
+	    "usage: server.exe [-p] [-d deno-socket] [-j threads] socket\n");
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct server server;
+	struct pool *pool;
+	char *end;
+	long n, ncpus;
+	int nthreads = 0, pin = 0;
+	int ch;
+
+	server.deno = NULL;
+	while ((ch = getopt(argc, argv, "d:j:p")) != -1) {
+		switch (ch) {
+		case 'd':
+			server.deno = optarg;
+			break;
+		case 'j':
+			n = strtol(optarg, &end, 10);
+			if (*optarg == '\0' || *end != '\0' ||
+			    n < 1 || n > POOL_MAX_THREADS)
+				errx(1, "threads must be between 1 and %d",
+				    POOL_MAX_THREADS);
+			nthreads = (int)n;
+			break;
+		case 'p':
+			pin = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc != 1)
+		usage();
+
+	if (nthreads == 0) {
+		ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = ncpus < 1 ? 1 : ncpus > POOL_MAX_THREADS ?
+		    POOL_MAX_THREADS : (int)ncpus;
+	}
+
+	/* A client that hangs up early must not take the server down. */
+	signal(SIGPIPE, SIG_IGN);
+	server.fd = listen_on(argv[0]);
+
+	if ((pool = pool_create(nthreads, pin)) == NULL)
+		err(1, "pool_create");
+
+	/*
+	 * One index per worker, each an accept loop that never returns, so
+	 * every worker keeps its own index and none is left to steal.
+	 */
+	pool_for(pool, (size_t)nthreads, 1, accept_loop, &server);
+
+	pool_destroy(pool);
+	return 0;
+}
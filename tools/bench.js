@@ -0,0 +1,227 @@
+/*
+ * Benchmark harness: runs every day a number of times after a warmup, with
+ * AOC_PHASES set so each run reports its own parse/part timings on stderr
+ * (see lib/phase.h), and summarises each phase as min/median/p95.  Run it
+ * with AOC_PERF=1 to have the C days' hardware counters recorded as well,
+ * or AOC_MEM=1 for every day's memory footprint.
+ *
+ *	deno run -A tools/bench.js [--runs N] [--warmup N] [--days 01,06]
+ *	    [--out bench.json]
+ *
+ * The C days must already be compiled; `make bench` does that first.
+ */
+
+const ROOT = new URL("../", import.meta.url).pathname;
+
+export const DAYS = [
+  { day: "01", kind: "c" },
+  { day: "02", kind: "c" },
+  { day: "03", kind: "c" },
+  { day: "04", kind: "c" },
+  { day: "05", kind: "c" },
+  { day: "06", kind: "deno" },
+  { day: "07", kind: "deno" },
+  { day: "08", kind: "deno" },
+  { day: "09", kind: "deno" },
+  { day: "10", kind: "c" },
+];
+
+/* Environment variables the Deno days may read. */
+const DENO_ENV = ["AOC_PHASES", "AOC_MEM"];
+
+function parseArgs(args) {
+  const options = { runs: 10, warmup: 2, days: null, out: "bench.json" };
+
+  for (let i = 0; i < args.length; ++i) {
+    const value = args[i + 1];
+    switch (args[i]) {
+      case "--runs":
+        options.runs = Number(value);
+        break;
+      case "--warmup":
+        options.warmup = Number(value);
+        break;
+      case "--days":
+        options.days = value.split(",").map((day) => day.padStart(2, "0"));
+        break;
+      case "--out":
+        options.out = value;
+        break;
+      default:
+        throw new Error(`unknown option ${args[i]}`);
+    }
+    ++i;
+  }
+
+  if (!(options.runs >= 1) || !(options.warmup >= 0)) {
+    throw new Error("--runs must be at least 1 and --warmup at least 0");
+  }
+  return options;
+}
+
+/* Command line for one run of a day on input, relative to its directory. */
+export function commandFor({ kind }, input) {
+  if (kind === "c") {
+    return ["./main.exe", input];
+  }
+  return [
+    Deno.execPath(),
+    "run",
+    "--allow-read",
+    `--allow-env=${DENO_ENV.join(",")}`,
+    "main.js",
+    input,
+  ];
+}
+
+/*
+ * Fields of every `phase` line on stderr, numbers converted; the name and
+ * labels such as perf_scope stay strings.
+ */
+export function parsePhases(stderr) {
+  const phases = [];
+  for (const line of stderr.split("\n")) {
+    const [tag, ...fields] = line.split("\t");
+    if (tag !== "phase") continue;
+
+    const phase = {};
+    for (const field of fields) {
+      const eq = field.indexOf("=");
+      const key = field.slice(0, eq), value = field.slice(eq + 1);
+      const number = Number(value);
+      phase[key] = key === "name" || Number.isNaN(number) ? value : number;
+    }
+    phases.push(phase);
+  }
+  return phases;
+}
+
+/*
+ * Run a day once.  Returns its stdout and phases, with the wall time of the
+ * whole process added as the "total" phase.
+ */
+export async function runDay(spec, { cwd, input, env = {} }) {
+  const [program, ...args] = commandFor(spec, input);
+
+  const start = performance.now();
+  const child = new Deno.Command(program, {
+    args,
+    cwd,
+    env: { AOC_PHASES: "1", ...env },
+    stdin: "null",
+    stdout: "piped",
+    stderr: "piped",
+  }).spawn();
+
+  const { code, stdout, stderr } = await child.output();
+  const totalNs = Math.round((performance.now() - start) * 1e6);
+
+  const decoder = new TextDecoder();
+  const errors = decoder.decode(stderr);
+  if (code !== 0) {
+    throw new Error(`day ${spec.day} exited with ${code}:\n${errors}`);
+  }
+
+  const phases = parsePhases(errors);
+  phases.push({ name: "total", time_ns: totalNs });
+  return { stdout: decoder.decode(stdout), phases };
+}
+
+/* Nearest-rank quantile of sorted samples. */
+function quantile(sorted, q) {
+  return sorted[Math.max(0, Math.ceil(q * sorted.length) - 1)];
+}
+
+export function summarize(samples) {
+  const sorted = [...samples].sort((a, b) => a - b);
+  return {
+    min_ns: sorted[0],
+    median_ns: quantile(sorted, 0.5),
+    p95_ns: quantile(sorted, 0.95),
+    samples,
+  };
+}
+
+function median(values) {
+  return quantile([...values].sort((a, b) => a - b), 0.5);
+}
+
+/*
+ * Run one day warmup + runs times and summarise every phase it reports.
+ * Fields other than the time, such as the AOC_PERF counters, are reduced
+ * to their medians, and labels to their first value.
+ */
+export async function benchDay(spec, { runs, warmup, cwd, input, env }) {
+  const samples = new Map();
+  let stdout = "";
+
+  for (let i = 0; i < warmup + runs; ++i) {
+    const result = await runDay(spec, { cwd, input, env });
+    stdout = result.stdout;
+    if (i < warmup) continue;
+
+    for (const { name, time_ns, ...fields } of result.phases) {
+      if (!samples.has(name)) samples.set(name, { times: [], fields: {} });
+      const phase = samples.get(name);
+      phase.times.push(time_ns);
+      for (const [key, value] of Object.entries(fields)) {
+        (phase.fields[key] ??= []).push(value);
+      }
+    }
+  }
+
+  const phases = {};
+  for (const [name, { times, fields }] of samples) {
+    phases[name] = summarize(times);
+    for (const [key, values] of Object.entries(fields)) {
+      phases[name][key] = typeof values[0] === "number"
+        ? median(values)
+        : values[0];
+    }
+  }
+  return { answers: stdout, phases };
+}
+
+function formatMs(ns) {
+  return (ns / 1e6).toFixed(3).padStart(10);
+}
+
+async function main() {
+  const options = parseArgs(Deno.args);
+  const days = options.days
+    ? DAYS.filter(({ day }) => options.days.includes(day))
+    : DAYS;
+
+  const results = {
+    runs: options.runs,
+    warmup: options.warmup,
+    days: [],
+  };
+
+  console.log("day  phase            min ms  median ms     p95 ms");
+  for (const spec of days) {
+    const cwd = `${ROOT}${spec.day}`;
+    const result = await benchDay(spec, {
+      runs: options.runs,
+      warmup: options.warmup,
+      cwd,
+      input: `${cwd}/input.txt`,
+    });
+    results.days.push({ day: spec.day, ...result });
+
+    for (const [name, stats] of Object.entries(result.phases)) {
+      console.log(
+        `${spec.day}   ${name.padEnd(10)} ${formatMs(stats.min_ns)} ${
+          formatMs(stats.median_ns)
+        } ${formatMs(stats.p95_ns)}`,
+      );
+    }
+  }
+
+  Deno.writeTextFileSync(options.out, JSON.stringify(results, null, 2) + "\n");
+  console.log(`results written to ${options.out}`);
+}
+
+if (import.meta.main) {
+  await main();
+}
@@ -0,0 +1,531 @@
+/*
+ * Synthetic input generator.  Writes a seeded input for every day, profile
+ * and scale, so the same command always produces the same files:
+ *
+ *	deno run --allow-write tools/gen.js [--seed N] [--days 01,05]
+ *	    [--scales 1,10,1000] [--profiles random,worst] [--out gen]
+ *
+ * Each input lands in <out>/<day>/<profile>-<scale>/input.txt, where the
+ * days that read ./input.txt can be run as they are.  With --out - a single
+ * day, profile and scale is written to stdout instead.
+ *
+ * A scale multiplies the size of the shipped input: line-based days get that
+ * many times the lines, grid days that many times the cells.  The "random"
+ * profile follows the shape of the shipped inputs; "worst" is built to make
+ * the solvers do as much work per byte as the format allows.
+ */
+
+export const PROFILES = ["random", "worst"];
+
+/* mulberry32: small, fast and good enough for test data. */
+function createRng(seed) {
+  let state = seed >>> 0;
+  const next = () => {
+    state = (state + 0x6d2b79f5) >>> 0;
+    let t = state;
+    t = Math.imul(t ^ (t >>> 15), t | 1);
+    t ^= t + Math.imul(t ^ (t >>> 7), t | 61);
+    return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+  };
+  return {
+    next,
+    /* Integer in [lo, hi]. */
+    int: (lo, hi) => lo + Math.floor(next() * (hi - lo + 1)),
+    chance: (p) => next() < p,
+    pick: (items) => items[Math.floor(next() * items.length)],
+  };
+}
+
+/* FNV-1a, to give every day/profile/scale its own stream from one seed. */
+function hashString(text) {
+  let hash = 0x811c9dc5;
+  for (let i = 0; i < text.length; ++i) {
+    hash = Math.imul(hash ^ text.charCodeAt(i), 0x01000193);
+  }
+  return hash >>> 0;
+}
+
+function shuffle(rng, items) {
+  for (let i = items.length - 1; i > 0; --i) {
+    const j = rng.int(0, i);
+    [items[i], items[j]] = [items[j], items[i]];
+  }
+  return items;
+}
+
+/* Side of a square grid with `scale` times the cells of a side x side one. */
+function scaledSide(side, scale) {
+  return Math.max(1, Math.round(side * Math.sqrt(scale)));
+}
+
+/* Two columns of five-digit location ids. */
+function genDay01(rng, scale, profile) {
+  const count = 1000 * scale;
+  const left = [], right = [];
+
+  for (let i = 0; i < count; ++i) {
+    left.push(rng.int(10000, 99999));
+    right.push(rng.chance(0.1) ? rng.pick(left) : rng.int(10000, 99999));
+  }
+  if (profile === "worst") {
+    /* Reverse-sorted for the sort, and every right id repeating a left one. */
+    left.sort((a, b) => b - a);
+    const common = Array.from({ length: 16 }, () => rng.pick(left));
+    for (let i = 0; i < count; ++i) {
+      right[i] = rng.pick(common);
+    }
+  }
+
+  return left.map((id, i) => `${id}   ${right[i]}`).join("\n") + "\n";
+}
+
+/* Reports of levels 1..99, about half of them safe. */
+function genDay02(rng, scale, profile) {
+  const lines = [];
+
+  for (let n = 0; n < 1000 * scale; ++n) {
+    const length = profile === "worst" ? 24 : rng.int(5, 8);
+    const step = profile === "worst" ? 1 : rng.int(1, 3);
+    const increasing = rng.chance(0.5);
+    const levels = [];
+    for (let level = rng.int(1, 99 - 3 * length); levels.length < length;) {
+      levels.push(level);
+      level += rng.int(1, step);
+    }
+    if (!increasing) levels.reverse();
+
+    /*
+     * One bad level, placed late for the worst profile so that every
+     * removal up to it has to be tried.
+     */
+    if (profile === "worst" || rng.chance(0.5)) {
+      const at = profile === "worst"
+        ? length - rng.int(1, 2)
+        : rng.int(0, length - 1);
+      const delta = profile === "worst" ? rng.pick([-4, 4]) : rng.pick([-4, 0, 4]);
+      levels[at] = Math.max(1, Math.min(99, levels[at] + delta));
+    }
+    lines.push(levels.join(" "));
+  }
+
+  return lines.join("\n") + "\n";
+}
+
+const NOISE = [
+  "who()", "what()", "why()", "how()", "when()", "where()", "select()",
+  "from()", "mul[3,7]", "mul(4*", "mul ( 2 , 4 )", "mul(32,64]", "do_not_mul(",
+  "!", "@", "#", "$", "%", "^", "&", "*", "(", ")", "[", "]", "{", "}", "<",
+  ">", "'", ",", "-", "+", "~", " ", ";", ":", "/", "?",
+];
+
+/* Corrupted memory: mul(a,b), do() and don't() buried in noise. */
+function genDay03(rng, scale, profile) {
+  const lines = [];
+
+  for (let n = 0; n < 6 * scale; ++n) {
+    const tokens = [];
+    for (let length = 0; length < 3000;) {
+      let token;
+      const roll = rng.next();
+      if (profile === "worst") {
+        /* Nothing but instructions and near misses. */
+        token = roll < 0.6
+          ? `mul(${rng.int(1, 999)},${rng.int(1, 999)})`
+          : roll < 0.8
+          ? rng.pick(["do()", "don't()"])
+          : rng.pick(["mul(", "mul(1", "mul(12,", "mul(123,4", "do(", "don't("]);
+      } else {
+        token = roll < 0.12
+          ? `mul(${rng.int(1, 999)},${rng.int(1, 999)})`
+          : roll < 0.135
+          ? rng.pick(["do()", "don't()"])
+          : rng.pick(NOISE);
+      }
+      tokens.push(token);
+      length += token.length;
+    }
+    lines.push(tokens.join(""));
+  }
+
+  return lines.join("\n") + "\n";
+}
+
+/* Letter grid for the XMAS search. */
+function genDay04(rng, scale, profile) {
+  const side = scaledSide(140, scale);
+  const lines = [];
+
+  for (let row = 0; row < side; ++row) {
+    let line = "";
+    for (let col = 0; col < side; ++col) {
+      /* The worst profile spells XMAS along every row and every column. */
+      line += "XMAS"[profile === "worst" ? (row + col) % 4 : rng.int(0, 3)];
+    }
+    lines.push(line);
+  }
+
+  return lines.join("\n") + "\n";
+}
+
+/*
+ * Ordering rules and updates.  The rules order every pair of 49 pages as a
+ * circular tournament: page i goes before the 24 pages that follow it around
+ * the circle.  That is cyclic as a whole, as in the real puzzle, but any
+ * update drawn from one arc of at most 25 pages has an acyclic rule set and
+ * so a single correct order.
+ */
+function genDay05(rng, scale, profile) {
+  const PAGES = 49, ARC = 25;
+  const pages = shuffle(rng, Array.from({ length: 89 }, (_, i) => i + 11))
+    .slice(0, PAGES);
+
+  const rules = [];
+  for (let i = 0; i < PAGES; ++i) {
+    for (let d = 1; d < ARC; ++d) {
+      rules.push(`${pages[i]}|${pages[(i + d) % PAGES]}`);
+    }
+  }
+  shuffle(rng, rules);
+
+  const updates = [];
+  for (let n = 0; n < 194 * scale; ++n) {
+    const first = rng.int(0, PAGES - 1);
+    const arc = Array.from({ length: ARC }, (_, d) => pages[(first + d) % PAGES]);
+    let update;
+    if (profile === "worst") {
+      /* Every page of the arc, in exactly the wrong order. */
+      update = arc.reverse();
+    } else {
+      const length = 2 * rng.int(2, 11) + 1;
+      update = arc.filter(() => rng.chance(length / ARC));
+      if (update.length % 2 === 0) update.pop();
+      if (update.length < 3) update = arc.slice(0, 3);
+      if (rng.chance(0.5)) shuffle(rng, update);
+    }
+    updates.push(update.join(","));
+  }
+
+  return rules.join("\n") + "\n\n" + updates.join("\n") + "\n";
+}
+
+const ROW_STEP = [-1, 0, 1, 0], COL_STEP = [0, 1, 0, -1];
+
+/*
+ * Walk the guard from the center.  Returns -1 when they leave the map, or
+ * else an obstacle they turn at while going round a loop.
+ */
+function findLoopObstacle(grid, side) {
+  const seen = new Uint8Array(side * side);
+  let row = side >> 1, col = side >> 1, facing = 0, looping = false;
+
+  while (true) {
+    const cell = row * side + col;
+    if (seen[cell] & (1 << facing)) looping = true;
+    seen[cell] |= 1 << facing;
+
+    const r = row + ROW_STEP[facing], c = col + COL_STEP[facing];
+    if (r < 0 || r >= side || c < 0 || c >= side) return -1;
+    if (grid[r][c] === "#") {
+      if (looping) return r * side + c;
+      facing = (facing + 1) % 4;
+    } else {
+      row = r;
+      col = c;
+    }
+  }
+}
+
+/* Lab map with a single guard facing north, who eventually walks off it. */
+function genDay06(rng, scale, profile) {
+  const side = scaledSide(130, scale);
+  const grid = Array.from({ length: side }, () => new Array(side).fill("."));
+  const center = side >> 1;
+
+  if (profile === "worst") {
+    /*
+     * A spiral the guard follows out from the center: walk 2, 2, 4, 4, 6,
+     * ... cells, with an obstacle at the end of each leg.  The rings are
+     * two cells apart, so the path covers half the map and every candidate
+     * obstruction sends the search around many turns.
+     */
+    let row = center, col = center;
+    for (let leg = 0;; ++leg) {
+      const facing = leg % 4, length = 2 * ((leg >> 1) + 1);
+      row += ROW_STEP[facing] * length;
+      col += COL_STEP[facing] * length;
+      const r = row + ROW_STEP[facing], c = col + COL_STEP[facing];
+      if (r < 0 || r >= side || c < 0 || c >= side) break;
+      grid[r][c] = "#";
+    }
+  } else {
+    for (let row = 0; row < side; ++row) {
+      for (let col = 0; col < side; ++col) {
+        if (rng.chance(0.05)) grid[row][col] = "#";
+      }
+    }
+    grid[center][center] = ".";
+    for (let cell; (cell = findLoopObstacle(grid, side)) !== -1;) {
+      grid[Math.floor(cell / side)][cell % side] = ".";
+    }
+  }
+  grid[center][center] = "^";
+
+  return grid.map((line) => line.join("")).join("\n") + "\n";
+}
+
+/* Calibration equations, about half of them solvable. */
+function genDay07(rng, scale, profile) {
+  const LIMIT = 10n ** 15n;
+  const lines = [];
+
+  for (let n = 0; n < 850 * scale; ++n) {
+    if (profile === "worst") {
+      /*
+       * Mostly ones: every operator can be undone at nearly every step, and
+       * the target is never reached, so the whole tree gets searched.
+       */
+      const operands = Array.from(
+        { length: 12 },
+        () => rng.chance(0.75) ? 1 : rng.int(2, 9),
+      );
+      lines.push(`${rng.int(1e10, 1e11 - 1)}1: ${operands.join(" ")}`);
+      continue;
+    }
+
+    /* A few equations too wide for a Number, for the BigInt path. */
+    const limit = rng.chance(0.01) ? LIMIT * 10000n : LIMIT;
+    let operands, target;
+    do {
+      operands = Array.from(
+        { length: rng.int(3, 12) },
+        () => rng.chance(0.7) ? rng.int(1, 9) : rng.int(10, 999),
+      );
+      target = BigInt(operands[0]);
+      for (let i = 1; i < operands.length; ++i) {
+        const operand = BigInt(operands[i]);
+        const operator = rng.int(0, 2);
+        target = operator === 0
+          ? target + operand
+          : operator === 1
+          ? target * operand
+          : BigInt(`${target}${operand}`);
+      }
+    } while (target >= limit);
+
+    if (rng.chance(0.5)) target += BigInt(rng.int(1, 9));
+    lines.push(`${target}: ${operands.join(" ")}`);
+  }
+
+  return lines.join("\n") + "\n";
+}
+
+const FREQUENCIES =
+  "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+/* Square antenna map, about 7% of the cells holding an antenna. */
+function genDay08(rng, scale, profile) {
+  const side = scaledSide(50, scale);
+  const grid = Array.from({ length: side }, () => new Array(side).fill("."));
+
+  /* The worst profile puts every antenna on one frequency: all pairs count. */
+  const frequencies = profile === "worst" ? "0" : FREQUENCIES;
+  for (let row = 0; row < side; ++row) {
+    for (let col = 0; col < side; ++col) {
+      if (rng.chance(0.074)) grid[row][col] = rng.pick(frequencies);
+    }
+  }
+
+  return grid.map((line) => line.join("")).join("\n") + "\n";
+}
+
+/* Disk map: alternating file and free lengths, ending on a file. */
+function genDay09(rng, scale, profile) {
+  const digits = new Uint8Array(20000 * scale);
+  const length = digits.length - 1;
+
+  for (let i = 0; i < length; ++i) {
+    const file = (i & 1) === 0;
+    if (profile === "worst") {
+      /* Files too long for every gap: each move searches and fails. */
+      digits[i] = 48 + (file ? 9 : rng.int(1, 8));
+    } else {
+      digits[i] = 48 + (file ? rng.int(1, 9) : rng.int(0, 9));
+    }
+  }
+  digits[length] = 10;
+
+  return digits;
+}
+
+/*
+ * Topographic map of heights 0-9.  The random profile raises pyramids
+ * around scattered summits, height 9 minus the distance to the nearest one,
+ * so trails from 0 to 9 are common as in the real puzzle; the worst profile
+ * is diagonal bands where every step right or down climbs by one, so every
+ * trailhead has the most trails the format allows.
+ */
+function genDay10(rng, scale, profile) {
+  const side = scaledSide(54, scale);
+  const heights = new Uint8Array(side * side);
+
+  if (profile === "worst") {
+    for (let row = 0; row < side; ++row) {
+      for (let col = 0; col < side; ++col) {
+        heights[row * side + col] = (row + col) % 10;
+      }
+    }
+  } else {
+    /* Multi-source BFS from the summits gives the distances. */
+    const distance = new Int32Array(side * side).fill(-1);
+    const queue = new Int32Array(side * side);
+    let head = 0, tail = 0;
+    for (let cell = 0; cell < side * side; ++cell) {
+      if (rng.chance(1 / 120)) {
+        distance[cell] = 0;
+        queue[tail++] = cell;
+      }
+    }
+    while (head < tail) {
+      const cell = queue[head++];
+      const row = Math.floor(cell / side), col = cell % side;
+      for (
+        const next of [
+          row > 0 ? cell - side : -1,
+          row < side - 1 ? cell + side : -1,
+          col > 0 ? cell - 1 : -1,
+          col < side - 1 ? cell + 1 : -1,
+        ]
+      ) {
+        if (next !== -1 && distance[next] === -1) {
+          distance[next] = distance[cell] + 1;
+          queue[tail++] = next;
+        }
+      }
+    }
+    for (let cell = 0; cell < side * side; ++cell) {
+      heights[cell] = distance[cell] === -1 || rng.chance(0.05)
+        ? rng.int(0, 9)
+        : Math.max(0, 9 - distance[cell]);
+    }
+  }
+
+  const text = new Uint8Array(side * (side + 1));
+  for (let row = 0, i = 0; row < side; ++row) {
+    for (let col = 0; col < side; ++col) {
+      text[i++] = 48 + heights[row * side + col];
+    }
+    text[i++] = 10;
+  }
+  return text;
+}
+
+export const GENERATORS = {
+  "01": genDay01,
+  "02": genDay02,
+  "03": genDay03,
+  "04": genDay04,
+  "05": genDay05,
+  "06": genDay06,
+  "07": genDay07,
+  "08": genDay08,
+  "09": genDay09,
+  "10": genDay10,
+};
+
+/* Input for one day, profile and scale; a string or UTF-8 bytes. */
+export function generate(day, profile, scale, seed = 1) {
+  const rng = createRng(hashString(`${seed}/${day}/${profile}/${scale}`));
+  return GENERATORS[day](rng, scale, profile);
+}
+
+function parseList(value) {
+  return value.split(",").filter((item) => item !== "");
+}
+
+function parseArgs(args) {
+  const options = {
+    seed: 1,
+    days: Object.keys(GENERATORS),
+    scales: [1, 10, 1000],
+    profiles: PROFILES,
+    out: "gen",
+  };
+
+  for (let i = 0; i < args.length; i += 2) {
+    const value = args[i + 1];
+    switch (args[i]) {
+      case "--seed":
+        options.seed = Number(value);
+        break;
+      case "--days":
+        options.days = parseList(value).map((day) => day.padStart(2, "0"));
+        break;
+      case "--scales":
+        options.scales = parseList(value).map(Number);
+        break;
+      case "--profiles":
+        options.profiles = parseList(value);
+        break;
+      case "--out":
+        options.out = value;
+        break;
+      default:
+        throw new Error(`unknown option ${args[i]}`);
+    }
+  }
+
+  for (const day of options.days) {
+    if (!(day in GENERATORS)) throw new Error(`no generator for day ${day}`);
+  }
+  for (const scale of options.scales) {
+    if (!Number.isInteger(scale) || scale < 1) {
+      throw new Error(`scale must be a positive integer: ${scale}`);
+    }
+  }
+  for (const profile of options.profiles) {
+    if (!PROFILES.includes(profile)) {
+      throw new Error(`unknown profile ${profile}`);
+    }
+  }
+  return options;
+}
+
+function toBytes(input) {
+  return typeof input === "string" ? new TextEncoder().encode(input) : input;
+}
+
+function main() {
+  const options = parseArgs(Deno.args);
+
+  if (options.out === "-") {
+    const { days, profiles, scales } = options;
+    if (days.length !== 1 || profiles.length !== 1 || scales.length !== 1) {
+      throw new Error("--out - needs exactly one day, profile and scale");
+    }
+    const bytes = toBytes(
+      generate(days[0], profiles[0], scales[0], options.seed),
+    );
+    for (let written = 0; written < bytes.length;) {
+      written += Deno.stdout.writeSync(bytes.subarray(written));
+    }
+    return;
+  }
+
+  for (const day of options.days) {
+    for (const profile of options.profiles) {
+      for (const scale of options.scales) {
+        const dir = `${options.out}/${day}/${profile}-${scale}`;
+        Deno.mkdirSync(dir, { recursive: true });
+        Deno.writeFileSync(
+          `${dir}/input.txt`,
+          toBytes(generate(day, profile, scale, options.seed)),
+        );
+        console.error(`${dir}/input.txt`);
+      }
+    }
+  }
+}
+
+if (import.meta.main) {
+  main();
+}
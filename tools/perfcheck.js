@@ -0,0 +1,195 @@
+/*
+ * Performance regression gate: runs every day on a generated input and
+ * compares the median time of each phase with tools/perf-baseline.json.
+ * A phase fails when it is slower than its baseline by more than the
+ * threshold (in percent) plus the slack (in ms, so that sub-millisecond
+ * phases do not fail on timer noise), and a day fails when its answers
+ * differ from the ones recorded with the baseline.
+ *
+ *	deno run -A tools/perfcheck.js [--input random-10] [--runs N]
+ *	    [--warmup N] [--threshold 10] [--slack-ms 0.25] [--days 01,06]
+ *	    [--baseline tools/perf-baseline.json] [--update]
+ *
+ * --update records a new baseline instead of checking against it.  The
+ * inputs come from `make gen`; times are only comparable on the machine
+ * the baseline was recorded on, so record it again when that changes.
+ */
+
+import { benchDay, DAYS } from "./bench.js";
+
+const ROOT = new URL("../", import.meta.url).pathname;
+
+function parseArgs(args) {
+  const options = {
+    input: "random-10",
+    runs: 10,
+    warmup: 2,
+    threshold: 10,
+    slackMs: 0.25,
+    days: null,
+    baseline: `${ROOT}tools/perf-baseline.json`,
+    update: false,
+  };
+
+  for (let i = 0; i < args.length; ++i) {
+    const value = args[i + 1];
+    switch (args[i]) {
+      case "--input":
+        options.input = value;
+        break;
+      case "--runs":
+        options.runs = Number(value);
+        break;
+      case "--warmup":
+        options.warmup = Number(value);
+        break;
+      case "--threshold":
+        options.threshold = Number(value);
+        break;
+      case "--slack-ms":
+        options.slackMs = Number(value);
+        break;
+      case "--days":
+        options.days = value.split(",").map((day) => day.padStart(2, "0"));
+        break;
+      case "--baseline":
+        options.baseline = value;
+        break;
+      case "--update":
+        options.update = true;
+        continue;
+      default:
+        throw new Error(`unknown option ${args[i]}`);
+    }
+    ++i;
+  }
+
+  if (!(options.runs >= 1) || !(options.warmup >= 0)) {
+    throw new Error("--runs must be at least 1 and --warmup at least 0");
+  }
+  if (!(options.threshold >= 0) || !(options.slackMs >= 0)) {
+    throw new Error("--threshold and --slack-ms must not be negative");
+  }
+  return options;
+}
+
+function inputFor(day, name) {
+  const path = `${ROOT}gen/${day}/${name}/input.txt`;
+  try {
+    Deno.statSync(path);
+  } catch {
+    throw new Error(`no input ${path}: run 'make gen' first`);
+  }
+  return path;
+}
+
+/* Median time of every phase of one day, with the answers it printed. */
+async function measure(spec, options) {
+  const { answers, phases } = await benchDay(spec, {
+    runs: options.runs,
+    warmup: options.warmup,
+    cwd: `${ROOT}${spec.day}`,
+    input: inputFor(spec.day, options.input),
+  });
+
+  const medians = {};
+  for (const [name, { median_ns }] of Object.entries(phases)) {
+    medians[name] = median_ns;
+  }
+  return { answers, phases: medians };
+}
+
+/*
+ * Lines describing how a day compares with its baseline entry, and
+ * whether it passed.
+ */
+export function compareDay(day, current, baseline, { threshold, slackMs }) {
+  const lines = [];
+  let ok = true;
+
+  if (baseline === undefined) {
+    return { ok: false, lines: [`${day}   no baseline recorded`] };
+  }
+  if (current.answers !== baseline.answers) {
+    ok = false;
+    lines.push(`${day}   answers differ from the baseline:`);
+    lines.push(current.answers.trimEnd().replace(/^/gm, "       "));
+  }
+
+  for (const [name, baseNs] of Object.entries(baseline.phases)) {
+    const ns = current.phases[name];
+    if (ns === undefined) {
+      ok = false;
+      lines.push(`${day}   ${name.padEnd(10)} missing`);
+      continue;
+    }
+
+    const limitNs = baseNs * (1 + threshold / 100) + slackMs * 1e6;
+    const change = baseNs > 0 ? (ns / baseNs - 1) * 100 : 0;
+    const status = ns > limitNs ? "SLOWER" : "ok";
+    if (ns > limitNs) ok = false;
+
+    lines.push(
+      `${day}   ${name.padEnd(10)} ${formatMs(baseNs)} ${formatMs(ns)} ${
+        `${change >= 0 ? "+" : ""}${change.toFixed(1)}%`.padStart(8)
+      }  ${status}`,
+    );
+  }
+  return { ok, lines };
+}
+
+function formatMs(ns) {
+  return (ns / 1e6).toFixed(3).padStart(10);
+}
+
+async function main() {
+  const options = parseArgs(Deno.args);
+  const days = options.days
+    ? DAYS.filter(({ day }) => options.days.includes(day))
+    : DAYS;
+
+  if (options.update) {
+    const baseline = { input: options.input, days: [] };
+    for (const spec of days) {
+      baseline.days.push({ day: spec.day, ...await measure(spec, options) });
+      console.error(`${spec.day} recorded`);
+    }
+    Deno.writeTextFileSync(
+      options.baseline,
+      JSON.stringify(baseline, null, 2) + "\n",
+    );
+    console.log(`baseline written to ${options.baseline}`);
+    return;
+  }
+
+  const baseline = JSON.parse(Deno.readTextFileSync(options.baseline));
+  if (baseline.input !== options.input) {
+    throw new Error(
+      `baseline was recorded on ${baseline.input}, not ${options.input}`,
+    );
+  }
+
+  let failed = 0;
+  console.log("day  phase           base ms    now ms   change");
+  for (const spec of days) {
+    const current = await measure(spec, options);
+    const { ok, lines } = compareDay(
+      spec.day,
+      current,
+      baseline.days.find(({ day }) => day === spec.day),
+      options,
+    );
+    console.log(lines.join("\n"));
+    if (!ok) ++failed;
+  }
+
+  if (failed > 0) {
+    console.log(`${failed} of ${days.length} days failed`);
+    Deno.exit(1);
+  }
+  console.log(`all ${days.length} days within ${options.threshold}%`);
+}
+
+if (import.meta.main) {
+  await main();
+}
@@ -0,0 +1,216 @@
+/*
+ * Resident solver for the Deno days, the counterpart of runner/server.c:
+ * days 06 to 09 are loaded once, so the JIT stays warm across requests,
+ * and answer on a Unix domain socket in the same protocol.  A connection
+ * carries any number of requests, each a line naming the day and where
+ * its input is:
+ *
+ *	<day> path <file>\n			input read by the server
+ *	<day> data <size>\n<size bytes>		input sent inline
+ *
+ * and each answered with one line of tab-separated fields, times in ms:
+ *
+ *	ok	part1=...	part2=...	parse=0.123	...	total=1.234
+ *	error	<message>
+ *
+ *	deno run --allow-read --allow-write tools/serve.js socket
+ *
+ * server.exe -d socket passes on the requests for these days, so clients
+ * can send every day to the one socket of the C server.  Connections are
+ * served concurrently on the event loop.
+ */
+
+const DAYS = ["06", "07", "08", "09"];
+const MAX_LINE = 4096 + 32;
+const MAX_PAYLOAD = 1 << 30;
+
+/* What byteReader's line() returns for a line that does not fit. */
+const TOO_LONG = Symbol("too long");
+
+const encoder = new TextEncoder();
+const decoder = new TextDecoder();
+
+/* Lines and fixed-size payloads off a byte stream; null once it ends. */
+function byteReader(readable) {
+  const reader = readable.getReader();
+  let buffer = new Uint8Array(0);
+
+  async function fill() {
+    const { value, done } = await reader.read();
+    if (done) return false;
+    const grown = new Uint8Array(buffer.length + value.length);
+    grown.set(buffer);
+    grown.set(value, buffer.length);
+    buffer = grown;
+    return true;
+  }
+
+  return {
+    /* The next line without its newline, or TOO_LONG. */
+    async line() {
+      for (;;) {
+        const newline = buffer.indexOf(10);
+        if (newline !== -1) {
+          const line = decoder.decode(buffer.subarray(0, newline));
+          buffer = buffer.subarray(newline + 1);
+          return line;
+        }
+        if (buffer.length >= MAX_LINE) return TOO_LONG;
+        if (!await fill()) return null;
+      }
+    },
+
+    async bytes(size) {
+      const bytes = new Uint8Array(size);
+      let filled = Math.min(size, buffer.length);
+      bytes.set(buffer.subarray(0, filled));
+      buffer = buffer.subarray(filled);
+
+      while (filled < size) {
+        const { value, done } = await reader.read();
+        if (done) return null;
+        const n = Math.min(size - filled, value.length);
+        bytes.set(value.subarray(0, n), filled);
+        buffer = value.subarray(n);
+        filled += n;
+      }
+      return bytes;
+    },
+  };
+}
+
+async function writeAll(conn, text) {
+  const bytes = encoder.encode(text);
+  for (let written = 0; written < bytes.length;) {
+    written += await conn.write(bytes.subarray(written));
+  }
+}
+
+function errorLine(message, arg) {
+  return `error\t${message}${arg !== undefined ? `: ${arg}` : ""}\n`;
+}
+
+function formatMs(ns) {
+  return (ns / 1e6).toFixed(3);
+}
+
+/* Run a day on input and format the answer line. */
+async function solveLine(day, solve, input) {
+  const times = [];
+  const start = performance.now();
+  let answers;
+  try {
+    answers = await solve(input, times);
+  } catch {
+    return errorLine("cannot parse input for day", day);
+  }
+  const totalNs = (performance.now() - start) * 1e6;
+
+  return `ok\tpart1=${answers.part1}\tpart2=${answers.part2}` +
+    times.map(({ name, ns }) => `\t${name}=${formatMs(ns)}`).join("") +
+    `\ttotal=${formatMs(totalNs)}\n`;
+}
+
+/*
+ * Answer one request line.  Returns false when the connection cannot go
+ * on, after a short inline payload or an unparsable size.  An inline
+ * payload is always read in full first, whatever the answer, so that it
+ * can never be taken for the next request.
+ */
+async function handle(solvers, line, reader, conn) {
+  const match = line.match(/^\s*(\S{1,7})\s+(\S{1,7})\s*(.*)$/);
+  if (match === null) {
+    await writeAll(conn, errorLine("bad request"));
+    return true;
+  }
+  const [, day, kind, arg] = match;
+  const solve = solvers.get(day);
+
+  let input;
+  if (kind === "path") {
+    if (arg === "" || arg === "-") {
+      await writeAll(conn, errorLine("bad path", arg));
+      return true;
+    }
+    if (solve === undefined) {
+      await writeAll(conn, errorLine("no such day", day));
+      return true;
+    }
+    try {
+      input = await Deno.readTextFile(arg);
+    } catch (error) {
+      await writeAll(conn, errorLine(error.message));
+      return true;
+    }
+  } else if (kind === "data") {
+    const size = /^\d+$/.test(arg) ? Number(arg) : NaN;
+    if (!(size <= MAX_PAYLOAD)) {
+      await writeAll(conn, errorLine("bad size", arg));
+      return false;
+    }
+    const bytes = await reader.bytes(size);
+    if (bytes === null) return false;
+    if (solve === undefined) {
+      await writeAll(conn, errorLine("no such day", day));
+      return true;
+    }
+    input = decoder.decode(bytes);
+  } else {
+    await writeAll(conn, errorLine("bad request", kind));
+    return true;
+  }
+
+  await writeAll(conn, await solveLine(day, solve, input));
+  return true;
+}
+
+async function serveConnection(solvers, conn) {
+  const reader = byteReader(conn.readable);
+  try {
+    for (;;) {
+      const line = await reader.line();
+      if (line === null) break;
+      if (line === TOO_LONG) {
+        await writeAll(conn, errorLine("request line too long"));
+        break;
+      }
+      if (!await handle(solvers, line, reader, conn)) break;
+    }
+  } catch (error) {
+    console.error(`serve.js: ${error.message}`);
+  } finally {
+    try {
+      conn.close();
+    } catch {
+      /* already closed by the peer */
+    }
+  }
+}
+
+async function main() {
+  if (Deno.args.length !== 1) {
+    console.error("usage: serve.js socket");
+    Deno.exit(1);
+  }
+  const path = Deno.args[0];
+
+  const solvers = new Map();
+  for (const day of DAYS) {
+    const url = new URL(`../${day}/main.js`, import.meta.url);
+    solvers.set(day, (await import(url.href)).solve);
+  }
+
+  try {
+    Deno.removeSync(path);
+  } catch (error) {
+    if (!(error instanceof Deno.errors.NotFound)) throw error;
+  }
+  const listener = Deno.listen({ transport: "unix", path });
+  for await (const conn of listener) {
+    serveConnection(solvers, conn);
+  }
+}
+
+if (import.meta.main) {
+  await main();
+}